@@ -19,6 +19,41 @@
  */
 
 #include "rmd160.h"
+#ifdef RMD160_DISPATCH
+#include <stdlib.h>
+#endif
+
+/*
+ * RMD160_DISPATCH compiles every kernel into one object and picks among
+ * them at run time, so the SIMD kernels carry a target attribute rather
+ * than relying on -mavx2 / -mavx512f for the whole file.
+ */
+#if defined(RMD160_DISPATCH) && (defined(__x86_64__) || defined(__i386__))
+#define RMD160_AVX2 __attribute__((target("avx2")))
+#define RMD160_AVX512F __attribute__((target("avx512f")))
+#define RMD160_AVX512VL __attribute__((target("avx512f,avx512vl")))
+#else
+#ifdef __AVX2__
+#define RMD160_AVX2
+#endif
+#ifdef __AVX512F__
+#define RMD160_AVX512F
+#ifdef __AVX512VL__
+#define RMD160_AVX512VL
+#endif
+#endif
+#endif
+#if defined(RMD160_AVX2) || defined(RMD160_AVX512F)
+#include <immintrin.h>
+#endif
+
+/*
+ * Kernel levels are supersets (see rmd160mix below), so without
+ * RMD160_DISPATCH an AVX2 or AVX-512 build also runs the unrolled kernel.
+ */
+#if !defined(RMD160_DISPATCH) && !defined(RMD160_UNROLL) && (defined(RMD160_AVX2) || defined(RMD160_AVX512F))
+#define RMD160_UNROLL
+#endif
 
 typedef unsigned int rmd160_bt; /* unsigned 32 bits */
 typedef int rmd160_bt_size_check[sizeof (rmd160_bt) == 4 ? 1 : -1];
@@ -37,23 +72,282 @@ rmd160tsize(
   return (sizeof (rmd160_t));
 }
 
-void
-rmd160init(
-  rmd160_t *v
+/*
+ * Unrolled step sequences: all 160 steps with the message word index,
+ * rotate amount and added constant of each step an immediate.
+ * The l (left) and r (right) lines rotate their a..e roles through the
+ * macro arguments rather than through (j + phase) % 5 arithmetic.
+ * A kernel defines RMD160_ADD, RMD160_ROL, RMD160_K and RMD160_F1..F5
+ * for its word type before expanding them.
+ */
+#define RMD160_S(a, b, c, d, e, f, k, x, s) \
+  a = RMD160_ADD(a, RMD160_ADD(f(b, c, d), RMD160_ADD(w[x], RMD160_K(k)))); \
+  a = RMD160_ADD(RMD160_ROL(a, s), e); \
+  c = RMD160_ROL(c, 10)
+
+#define RMD160_L1(a, b, c, d, e) \
+  RMD160_S(a, b, c, d, e, RMD160_F1, 0x00000000U,  0, 11); \
+  RMD160_S(e, a, b, c, d, RMD160_F1, 0x00000000U,  1, 14); \
+  RMD160_S(d, e, a, b, c, RMD160_F1, 0x00000000U,  2, 15); \
+  RMD160_S(c, d, e, a, b, RMD160_F1, 0x00000000U,  3, 12); \
+  RMD160_S(b, c, d, e, a, RMD160_F1, 0x00000000U,  4,  5); \
+  RMD160_S(a, b, c, d, e, RMD160_F1, 0x00000000U,  5,  8); \
+  RMD160_S(e, a, b, c, d, RMD160_F1, 0x00000000U,  6,  7); \
+  RMD160_S(d, e, a, b, c, RMD160_F1, 0x00000000U,  7,  9); \
+  RMD160_S(c, d, e, a, b, RMD160_F1, 0x00000000U,  8, 11); \
+  RMD160_S(b, c, d, e, a, RMD160_F1, 0x00000000U,  9, 13); \
+  RMD160_S(a, b, c, d, e, RMD160_F1, 0x00000000U, 10, 14); \
+  RMD160_S(e, a, b, c, d, RMD160_F1, 0x00000000U, 11, 15); \
+  RMD160_S(d, e, a, b, c, RMD160_F1, 0x00000000U, 12,  6); \
+  RMD160_S(c, d, e, a, b, RMD160_F1, 0x00000000U, 13,  7); \
+  RMD160_S(b, c, d, e, a, RMD160_F1, 0x00000000U, 14,  9); \
+  RMD160_S(a, b, c, d, e, RMD160_F1, 0x00000000U, 15,  8)
+
+#define RMD160_R1(a, b, c, d, e) \
+  RMD160_S(a, b, c, d, e, RMD160_F5, 0x50a28be6U,  5,  8); \
+  RMD160_S(e, a, b, c, d, RMD160_F5, 0x50a28be6U, 14,  9); \
+  RMD160_S(d, e, a, b, c, RMD160_F5, 0x50a28be6U,  7,  9); \
+  RMD160_S(c, d, e, a, b, RMD160_F5, 0x50a28be6U,  0, 11); \
+  RMD160_S(b, c, d, e, a, RMD160_F5, 0x50a28be6U,  9, 13); \
+  RMD160_S(a, b, c, d, e, RMD160_F5, 0x50a28be6U,  2, 15); \
+  RMD160_S(e, a, b, c, d, RMD160_F5, 0x50a28be6U, 11, 15); \
+  RMD160_S(d, e, a, b, c, RMD160_F5, 0x50a28be6U,  4,  5); \
+  RMD160_S(c, d, e, a, b, RMD160_F5, 0x50a28be6U, 13,  7); \
+  RMD160_S(b, c, d, e, a, RMD160_F5, 0x50a28be6U,  6,  7); \
+  RMD160_S(a, b, c, d, e, RMD160_F5, 0x50a28be6U, 15,  8); \
+  RMD160_S(e, a, b, c, d, RMD160_F5, 0x50a28be6U,  8, 11); \
+  RMD160_S(d, e, a, b, c, RMD160_F5, 0x50a28be6U,  1, 14); \
+  RMD160_S(c, d, e, a, b, RMD160_F5, 0x50a28be6U, 10, 14); \
+  RMD160_S(b, c, d, e, a, RMD160_F5, 0x50a28be6U,  3, 12); \
+  RMD160_S(a, b, c, d, e, RMD160_F5, 0x50a28be6U, 12,  6)
+
+#define RMD160_L2(a, b, c, d, e) \
+  RMD160_S(a, b, c, d, e, RMD160_F2, 0x5a827999U,  7,  7); \
+  RMD160_S(e, a, b, c, d, RMD160_F2, 0x5a827999U,  4,  6); \
+  RMD160_S(d, e, a, b, c, RMD160_F2, 0x5a827999U, 13,  8); \
+  RMD160_S(c, d, e, a, b, RMD160_F2, 0x5a827999U,  1, 13); \
+  RMD160_S(b, c, d, e, a, RMD160_F2, 0x5a827999U, 10, 11); \
+  RMD160_S(a, b, c, d, e, RMD160_F2, 0x5a827999U,  6,  9); \
+  RMD160_S(e, a, b, c, d, RMD160_F2, 0x5a827999U, 15,  7); \
+  RMD160_S(d, e, a, b, c, RMD160_F2, 0x5a827999U,  3, 15); \
+  RMD160_S(c, d, e, a, b, RMD160_F2, 0x5a827999U, 12,  7); \
+  RMD160_S(b, c, d, e, a, RMD160_F2, 0x5a827999U,  0, 12); \
+  RMD160_S(a, b, c, d, e, RMD160_F2, 0x5a827999U,  9, 15); \
+  RMD160_S(e, a, b, c, d, RMD160_F2, 0x5a827999U,  5,  9); \
+  RMD160_S(d, e, a, b, c, RMD160_F2, 0x5a827999U,  2, 11); \
+  RMD160_S(c, d, e, a, b, RMD160_F2, 0x5a827999U, 14,  7); \
+  RMD160_S(b, c, d, e, a, RMD160_F2, 0x5a827999U, 11, 13); \
+  RMD160_S(a, b, c, d, e, RMD160_F2, 0x5a827999U,  8, 12)
+
+#define RMD160_R2(a, b, c, d, e) \
+  RMD160_S(a, b, c, d, e, RMD160_F4, 0x5c4dd124U,  6,  9); \
+  RMD160_S(e, a, b, c, d, RMD160_F4, 0x5c4dd124U, 11, 13); \
+  RMD160_S(d, e, a, b, c, RMD160_F4, 0x5c4dd124U,  3, 15); \
+  RMD160_S(c, d, e, a, b, RMD160_F4, 0x5c4dd124U,  7,  7); \
+  RMD160_S(b, c, d, e, a, RMD160_F4, 0x5c4dd124U,  0, 12); \
+  RMD160_S(a, b, c, d, e, RMD160_F4, 0x5c4dd124U, 13,  8); \
+  RMD160_S(e, a, b, c, d, RMD160_F4, 0x5c4dd124U,  5,  9); \
+  RMD160_S(d, e, a, b, c, RMD160_F4, 0x5c4dd124U, 10, 11); \
+  RMD160_S(c, d, e, a, b, RMD160_F4, 0x5c4dd124U, 14,  7); \
+  RMD160_S(b, c, d, e, a, RMD160_F4, 0x5c4dd124U, 15,  7); \
+  RMD160_S(a, b, c, d, e, RMD160_F4, 0x5c4dd124U,  8, 12); \
+  RMD160_S(e, a, b, c, d, RMD160_F4, 0x5c4dd124U, 12,  7); \
+  RMD160_S(d, e, a, b, c, RMD160_F4, 0x5c4dd124U,  4,  6); \
+  RMD160_S(c, d, e, a, b, RMD160_F4, 0x5c4dd124U,  9, 15); \
+  RMD160_S(b, c, d, e, a, RMD160_F4, 0x5c4dd124U,  1, 13); \
+  RMD160_S(a, b, c, d, e, RMD160_F4, 0x5c4dd124U,  2, 11)
+
+#define RMD160_L3(a, b, c, d, e) \
+  RMD160_S(a, b, c, d, e, RMD160_F3, 0x6ed9eba1U,  3, 11); \
+  RMD160_S(e, a, b, c, d, RMD160_F3, 0x6ed9eba1U, 10, 13); \
+  RMD160_S(d, e, a, b, c, RMD160_F3, 0x6ed9eba1U, 14,  6); \
+  RMD160_S(c, d, e, a, b, RMD160_F3, 0x6ed9eba1U,  4,  7); \
+  RMD160_S(b, c, d, e, a, RMD160_F3, 0x6ed9eba1U,  9, 14); \
+  RMD160_S(a, b, c, d, e, RMD160_F3, 0x6ed9eba1U, 15,  9); \
+  RMD160_S(e, a, b, c, d, RMD160_F3, 0x6ed9eba1U,  8, 13); \
+  RMD160_S(d, e, a, b, c, RMD160_F3, 0x6ed9eba1U,  1, 15); \
+  RMD160_S(c, d, e, a, b, RMD160_F3, 0x6ed9eba1U,  2, 14); \
+  RMD160_S(b, c, d, e, a, RMD160_F3, 0x6ed9eba1U,  7,  8); \
+  RMD160_S(a, b, c, d, e, RMD160_F3, 0x6ed9eba1U,  0, 13); \
+  RMD160_S(e, a, b, c, d, RMD160_F3, 0x6ed9eba1U,  6,  6); \
+  RMD160_S(d, e, a, b, c, RMD160_F3, 0x6ed9eba1U, 13,  5); \
+  RMD160_S(c, d, e, a, b, RMD160_F3, 0x6ed9eba1U, 11, 12); \
+  RMD160_S(b, c, d, e, a, RMD160_F3, 0x6ed9eba1U,  5,  7); \
+  RMD160_S(a, b, c, d, e, RMD160_F3, 0x6ed9eba1U, 12,  5)
+
+#define RMD160_R3(a, b, c, d, e) \
+  RMD160_S(a, b, c, d, e, RMD160_F3, 0x6d703ef3U, 15,  9); \
+  RMD160_S(e, a, b, c, d, RMD160_F3, 0x6d703ef3U,  5,  7); \
+  RMD160_S(d, e, a, b, c, RMD160_F3, 0x6d703ef3U,  1, 15); \
+  RMD160_S(c, d, e, a, b, RMD160_F3, 0x6d703ef3U,  3, 11); \
+  RMD160_S(b, c, d, e, a, RMD160_F3, 0x6d703ef3U,  7,  8); \
+  RMD160_S(a, b, c, d, e, RMD160_F3, 0x6d703ef3U, 14,  6); \
+  RMD160_S(e, a, b, c, d, RMD160_F3, 0x6d703ef3U,  6,  6); \
+  RMD160_S(d, e, a, b, c, RMD160_F3, 0x6d703ef3U,  9, 14); \
+  RMD160_S(c, d, e, a, b, RMD160_F3, 0x6d703ef3U, 11, 12); \
+  RMD160_S(b, c, d, e, a, RMD160_F3, 0x6d703ef3U,  8, 13); \
+  RMD160_S(a, b, c, d, e, RMD160_F3, 0x6d703ef3U, 12,  5); \
+  RMD160_S(e, a, b, c, d, RMD160_F3, 0x6d703ef3U,  2, 14); \
+  RMD160_S(d, e, a, b, c, RMD160_F3, 0x6d703ef3U, 10, 13); \
+  RMD160_S(c, d, e, a, b, RMD160_F3, 0x6d703ef3U,  0, 13); \
+  RMD160_S(b, c, d, e, a, RMD160_F3, 0x6d703ef3U,  4,  7); \
+  RMD160_S(a, b, c, d, e, RMD160_F3, 0x6d703ef3U, 13,  5)
+
+#define RMD160_L4(a, b, c, d, e) \
+  RMD160_S(a, b, c, d, e, RMD160_F4, 0x8f1bbcdcU,  1, 11); \
+  RMD160_S(e, a, b, c, d, RMD160_F4, 0x8f1bbcdcU,  9, 12); \
+  RMD160_S(d, e, a, b, c, RMD160_F4, 0x8f1bbcdcU, 11, 14); \
+  RMD160_S(c, d, e, a, b, RMD160_F4, 0x8f1bbcdcU, 10, 15); \
+  RMD160_S(b, c, d, e, a, RMD160_F4, 0x8f1bbcdcU,  0, 14); \
+  RMD160_S(a, b, c, d, e, RMD160_F4, 0x8f1bbcdcU,  8, 15); \
+  RMD160_S(e, a, b, c, d, RMD160_F4, 0x8f1bbcdcU, 12,  9); \
+  RMD160_S(d, e, a, b, c, RMD160_F4, 0x8f1bbcdcU,  4,  8); \
+  RMD160_S(c, d, e, a, b, RMD160_F4, 0x8f1bbcdcU, 13,  9); \
+  RMD160_S(b, c, d, e, a, RMD160_F4, 0x8f1bbcdcU,  3, 14); \
+  RMD160_S(a, b, c, d, e, RMD160_F4, 0x8f1bbcdcU,  7,  5); \
+  RMD160_S(e, a, b, c, d, RMD160_F4, 0x8f1bbcdcU, 15,  6); \
+  RMD160_S(d, e, a, b, c, RMD160_F4, 0x8f1bbcdcU, 14,  8); \
+  RMD160_S(c, d, e, a, b, RMD160_F4, 0x8f1bbcdcU,  5,  6); \
+  RMD160_S(b, c, d, e, a, RMD160_F4, 0x8f1bbcdcU,  6,  5); \
+  RMD160_S(a, b, c, d, e, RMD160_F4, 0x8f1bbcdcU,  2, 12)
+
+#define RMD160_R4(a, b, c, d, e) \
+  RMD160_S(a, b, c, d, e, RMD160_F2, 0x7a6d76e9U,  8, 15); \
+  RMD160_S(e, a, b, c, d, RMD160_F2, 0x7a6d76e9U,  6,  5); \
+  RMD160_S(d, e, a, b, c, RMD160_F2, 0x7a6d76e9U,  4,  8); \
+  RMD160_S(c, d, e, a, b, RMD160_F2, 0x7a6d76e9U,  1, 11); \
+  RMD160_S(b, c, d, e, a, RMD160_F2, 0x7a6d76e9U,  3, 14); \
+  RMD160_S(a, b, c, d, e, RMD160_F2, 0x7a6d76e9U, 11, 14); \
+  RMD160_S(e, a, b, c, d, RMD160_F2, 0x7a6d76e9U, 15,  6); \
+  RMD160_S(d, e, a, b, c, RMD160_F2, 0x7a6d76e9U,  0, 14); \
+  RMD160_S(c, d, e, a, b, RMD160_F2, 0x7a6d76e9U,  5,  6); \
+  RMD160_S(b, c, d, e, a, RMD160_F2, 0x7a6d76e9U, 12,  9); \
+  RMD160_S(a, b, c, d, e, RMD160_F2, 0x7a6d76e9U,  2, 12); \
+  RMD160_S(e, a, b, c, d, RMD160_F2, 0x7a6d76e9U, 13,  9); \
+  RMD160_S(d, e, a, b, c, RMD160_F2, 0x7a6d76e9U,  9, 12); \
+  RMD160_S(c, d, e, a, b, RMD160_F2, 0x7a6d76e9U,  7,  5); \
+  RMD160_S(b, c, d, e, a, RMD160_F2, 0x7a6d76e9U, 10, 15); \
+  RMD160_S(a, b, c, d, e, RMD160_F2, 0x7a6d76e9U, 14,  8)
+
+#define RMD160_L5(a, b, c, d, e) \
+  RMD160_S(a, b, c, d, e, RMD160_F5, 0xa953fd4eU,  4,  9); \
+  RMD160_S(e, a, b, c, d, RMD160_F5, 0xa953fd4eU,  0, 15); \
+  RMD160_S(d, e, a, b, c, RMD160_F5, 0xa953fd4eU,  5,  5); \
+  RMD160_S(c, d, e, a, b, RMD160_F5, 0xa953fd4eU,  9, 11); \
+  RMD160_S(b, c, d, e, a, RMD160_F5, 0xa953fd4eU,  7,  6); \
+  RMD160_S(a, b, c, d, e, RMD160_F5, 0xa953fd4eU, 12,  8); \
+  RMD160_S(e, a, b, c, d, RMD160_F5, 0xa953fd4eU,  2, 13); \
+  RMD160_S(d, e, a, b, c, RMD160_F5, 0xa953fd4eU, 10, 12); \
+  RMD160_S(c, d, e, a, b, RMD160_F5, 0xa953fd4eU, 14,  5); \
+  RMD160_S(b, c, d, e, a, RMD160_F5, 0xa953fd4eU,  1, 12); \
+  RMD160_S(a, b, c, d, e, RMD160_F5, 0xa953fd4eU,  3, 13); \
+  RMD160_S(e, a, b, c, d, RMD160_F5, 0xa953fd4eU,  8, 14); \
+  RMD160_S(d, e, a, b, c, RMD160_F5, 0xa953fd4eU, 11, 11); \
+  RMD160_S(c, d, e, a, b, RMD160_F5, 0xa953fd4eU,  6,  8); \
+  RMD160_S(b, c, d, e, a, RMD160_F5, 0xa953fd4eU, 15,  5); \
+  RMD160_S(a, b, c, d, e, RMD160_F5, 0xa953fd4eU, 13,  6)
+
+#define RMD160_R5(a, b, c, d, e) \
+  RMD160_S(a, b, c, d, e, RMD160_F1, 0x00000000U, 12,  8); \
+  RMD160_S(e, a, b, c, d, RMD160_F1, 0x00000000U, 15,  5); \
+  RMD160_S(d, e, a, b, c, RMD160_F1, 0x00000000U, 10, 12); \
+  RMD160_S(c, d, e, a, b, RMD160_F1, 0x00000000U,  4,  9); \
+  RMD160_S(b, c, d, e, a, RMD160_F1, 0x00000000U,  1, 12); \
+  RMD160_S(a, b, c, d, e, RMD160_F1, 0x00000000U,  5,  5); \
+  RMD160_S(e, a, b, c, d, RMD160_F1, 0x00000000U,  8, 14); \
+  RMD160_S(d, e, a, b, c, RMD160_F1, 0x00000000U,  7,  6); \
+  RMD160_S(c, d, e, a, b, RMD160_F1, 0x00000000U,  6,  8); \
+  RMD160_S(b, c, d, e, a, RMD160_F1, 0x00000000U,  2, 13); \
+  RMD160_S(a, b, c, d, e, RMD160_F1, 0x00000000U, 13,  6); \
+  RMD160_S(e, a, b, c, d, RMD160_F1, 0x00000000U, 14,  5); \
+  RMD160_S(d, e, a, b, c, RMD160_F1, 0x00000000U,  0, 15); \
+  RMD160_S(c, d, e, a, b, RMD160_F1, 0x00000000U,  3, 13); \
+  RMD160_S(b, c, d, e, a, RMD160_F1, 0x00000000U,  9, 11); \
+  RMD160_S(a, b, c, d, e, RMD160_F1, 0x00000000U, 11, 11)
+
+#if defined(RMD160_DISPATCH) || (defined(RMD160_UNROLL) && !defined(RMD160_AVX512VL))
+
+/* speed profile */
+#define RMD160_ADD(x, y) ((x) + (y))
+#define RMD160_ROL(x, n) (((x) << (n)) | ((x) >> (sizeof (rmd160_bt) * 8 - (n))))
+#define RMD160_K(k) (k)
+#define RMD160_F1(x, y, z) ((x) ^ (y) ^ (z))                /* x XOR y XOR z */
+#define RMD160_F2(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))      /* (x AND y) OR (NOT(x) AND z) */
+#define RMD160_F3(x, y, z) (((x) | ~(y)) ^ (z))             /* (x OR NOT(y)) XOR z */
+#define RMD160_F4(x, y, z) ((y) ^ ((z) & ((x) ^ (y))))      /* (x AND z) OR (y AND NOT(z)) */
+#define RMD160_F5(x, y, z) ((x) ^ ((y) | ~(z)))             /* x XOR (y OR NOT(z)) */
+
+/* the chaining value stays in h0..h4 across all n blocks */
+static void
+rmd160mixu(
+  rmd160_bt h[]
+ ,const unsigned char x[]
+ ,size_t n
 ){
-  v->h[0] = 0x67452301U;
-  v->h[1] = 0xefcdab89U;
-  v->h[2] = 0x98badcfeU;
-  v->h[3] = 0x10325476U;
-  v->h[4] = 0xc3d2e1f0U;
-  v->bh = v->bl = 0;
-  v->l = 0;
+  rmd160_bt w[16]; /* precomputed message words */
+  rmd160_bt h0, h1, h2, h3, h4;
+  rmd160_bt al, bl, cl, dl, el;
+  rmd160_bt ar, br, cr, dr, er;
+  rmd160_bt f;
+  unsigned int i;
+
+  h0 = h[0];
+  h1 = h[1];
+  h2 = h[2];
+  h3 = h[3];
+  h4 = h[4];
+  for (; n; --n, x += 64) {
+    for (i = 0; i < 16; ++i)
+      w[i] = (rmd160_bt)x[i * 4] | (rmd160_bt)x[i * 4 + 1] << 8
+           | (rmd160_bt)x[i * 4 + 2] << 16 | (rmd160_bt)x[i * 4 + 3] << 24;
+    al = ar = h0;
+    bl = br = h1;
+    cl = cr = h2;
+    dl = dr = h3;
+    el = er = h4;
+    RMD160_L1(al, bl, cl, dl, el);
+    RMD160_R1(ar, br, cr, dr, er);
+    RMD160_L2(el, al, bl, cl, dl);
+    RMD160_R2(er, ar, br, cr, dr);
+    RMD160_L3(dl, el, al, bl, cl);
+    RMD160_R3(dr, er, ar, br, cr);
+    RMD160_L4(cl, dl, el, al, bl);
+    RMD160_R4(cr, dr, er, ar, br);
+    RMD160_L5(bl, cl, dl, el, al);
+    RMD160_R5(br, cr, dr, er, ar);
+     f = RMD160_ADD(h1, RMD160_ADD(cl, dr));
+    h1 = RMD160_ADD(h2, RMD160_ADD(dl, er));
+    h2 = RMD160_ADD(h3, RMD160_ADD(el, ar));
+    h3 = RMD160_ADD(h4, RMD160_ADD(al, br));
+    h4 = RMD160_ADD(h0, RMD160_ADD(bl, cr));
+    h0 = f;
+  }
+  h[0] = h0;
+  h[1] = h1;
+  h[2] = h2;
+  h[3] = h3;
+  h[4] = h4;
 }
 
+#undef RMD160_ADD
+#undef RMD160_ROL
+#undef RMD160_K
+#undef RMD160_F1
+#undef RMD160_F2
+#undef RMD160_F3
+#undef RMD160_F4
+#undef RMD160_F5
+
+#endif /* RMD160_DISPATCH || (RMD160_UNROLL && !RMD160_AVX512VL) */
+
+#if !defined(RMD160_UNROLL) || defined(RMD160_DISPATCH)
+
+/* size profile */
 static void
-rmd160mix(
+rmd160mixl(
   rmd160_bt h[]
  ,const unsigned char x[]
+ ,size_t n
 ){
   static const rmd160_bt k[10] = { /* added constants */
     0x00000000U
@@ -99,57 +393,630 @@ rmd160mix(
   unsigned int base, phase, jm;
   unsigned int a, b, c, d, e;
 
-  for (i = 0; i < 16; ++i)
-    w[i] = (rmd160_bt)x[i * 4] | (rmd160_bt)x[i * 4 + 1] << 8
-         | (rmd160_bt)x[i * 4 + 2] << 16 | (rmd160_bt)x[i * 4 + 3] << 24;
-  for (i = 0; i < 5; ++i)
-    t[5 + i] = t[i] = h[i];
-  for (i = 0; i < 10; ++i) {
-    base = (i & 1) * 5;
-    phase = i >> 1;
-    for (j = 0; j < 16; ++j) {
-      jm = (j + phase) % 5;
-      a = base + (5u - jm) % 5;
-      b = base + (6u - jm) % 5;
-      c = base + (7u - jm) % 5;
-      d = base + (8u - jm) % 5;
-      e = base + (9u - jm) % 5;
-      switch (i) {
-      case 0: case 9: /* x XOR y XOR z */
-        f = t[b] ^ t[c] ^ t[d];
-        break;
-      case 2: case 7: /* (x AND y) OR (NOT(x) AND z) */
-        f = t[d] ^ (t[b] & (t[c] ^ t[d]));
-        break;
-      case 4: case 5: /* (x OR NOT(y)) XOR z */
-        f = (t[b] | ~t[c]) ^ t[d];
-        break;
-      case 6: case 3: /* (x AND z) OR (y AND NOT(z)) */
-        f = t[c] ^ (t[d] & (t[b] ^ t[c]));
-        break;
-      case 8: case 1: /* x XOR (y OR NOT(z)) */
-        f = t[b] ^ (t[c] | ~t[d]);
-        break;
+  for (; n; --n, x += 64) {
+    for (i = 0; i < 16; ++i)
+      w[i] = (rmd160_bt)x[i * 4] | (rmd160_bt)x[i * 4 + 1] << 8
+           | (rmd160_bt)x[i * 4 + 2] << 16 | (rmd160_bt)x[i * 4 + 3] << 24;
+    for (i = 0; i < 5; ++i)
+      t[5 + i] = t[i] = h[i];
+    for (i = 0; i < 10; ++i) {
+      base = (i & 1) * 5;
+      phase = i >> 1;
+      for (j = 0; j < 16; ++j) {
+        jm = (j + phase) % 5;
+        a = base + (5u - jm) % 5;
+        b = base + (6u - jm) % 5;
+        c = base + (7u - jm) % 5;
+        d = base + (8u - jm) % 5;
+        e = base + (9u - jm) % 5;
+        switch (i) {
+        case 0: case 9: /* x XOR y XOR z */
+          f = t[b] ^ t[c] ^ t[d];
+          break;
+        case 2: case 7: /* (x AND y) OR (NOT(x) AND z) */
+          f = t[d] ^ (t[b] & (t[c] ^ t[d]));
+          break;
+        case 4: case 5: /* (x OR NOT(y)) XOR z */
+          f = (t[b] | ~t[c]) ^ t[d];
+          break;
+        case 6: case 3: /* (x AND z) OR (y AND NOT(z)) */
+          f = t[c] ^ (t[d] & (t[b] ^ t[c]));
+          break;
+        case 8: case 1: /* x XOR (y OR NOT(z)) */
+          f = t[b] ^ (t[c] | ~t[d]);
+          break;
+        }
+        f += t[a] + w[r[i][j]] + k[i];
+        t[a] = ((f << s[i][j]) | (f >> (sizeof (rmd160_bt) * 8 - s[i][j]))) /* rotate left */
+             + t[e];
+        t[c] = (t[c] << 10) | (t[c] >> (sizeof (rmd160_bt) * 8 - 10)); /* rotate left */
       }
-      f += t[a] + w[r[i][j]] + k[i];
-      t[a] = ((f << s[i][j]) | (f >> (sizeof (rmd160_bt) * 8 - s[i][j]))) /* rotate left */
-           + t[e];
-      t[c] = (t[c] << 10) | (t[c] >> (sizeof (rmd160_bt) * 8 - 10)); /* rotate left */
     }
+       f = h[1] + t[2] + t[8];
+    h[1] = h[2] + t[3] + t[9];
+    h[2] = h[3] + t[4] + t[5];
+    h[3] = h[4] + t[0] + t[6];
+    h[4] = h[0] + t[1] + t[7];
+    h[0] = f;
   }
-     f = h[1] + t[2] + t[8];
-  h[1] = h[2] + t[3] + t[9];
-  h[2] = h[3] + t[4] + t[5];
-  h[3] = h[4] + t[0] + t[6];
-  h[4] = h[0] + t[1] + t[7];
-  h[0] = f;
 }
 
+#endif /* !RMD160_UNROLL || RMD160_DISPATCH */
+
+#if (defined(RMD160_UNROLL) || defined(RMD160_DISPATCH)) && defined(RMD160_AVX512VL)
+
+/*
+ * Paired step sequences: step j of the left line and step j of the right
+ * line as one step on a register whose lane 0 is the left line and lane 1
+ * the right, each with its own message word and rotate amount.
+ * The lines share the a..e role rotation, only the round functions and
+ * added constants differ.
+ */
+#define RMD160_T(a, b, c, d, e, g, xl, sl, xr, sr) \
+  a = _mm_add_epi32(_mm_add_epi32(a, RMD160_W(xl, xr)), g(b, c, d)); \
+  a = _mm_add_epi32(_mm_rolv_epi32(a, _mm_set_epi32(0, 0, sr, sl)), e); \
+  c = _mm_rol_epi32(c, 10)
+
+#define RMD160_P1(a, b, c, d, e) \
+  RMD160_T(a, b, c, d, e, RMD160_G1,  0, 11,  5,  8); \
+  RMD160_T(e, a, b, c, d, RMD160_G1,  1, 14, 14,  9); \
+  RMD160_T(d, e, a, b, c, RMD160_G1,  2, 15,  7,  9); \
+  RMD160_T(c, d, e, a, b, RMD160_G1,  3, 12,  0, 11); \
+  RMD160_T(b, c, d, e, a, RMD160_G1,  4,  5,  9, 13); \
+  RMD160_T(a, b, c, d, e, RMD160_G1,  5,  8,  2, 15); \
+  RMD160_T(e, a, b, c, d, RMD160_G1,  6,  7, 11, 15); \
+  RMD160_T(d, e, a, b, c, RMD160_G1,  7,  9,  4,  5); \
+  RMD160_T(c, d, e, a, b, RMD160_G1,  8, 11, 13,  7); \
+  RMD160_T(b, c, d, e, a, RMD160_G1,  9, 13,  6,  7); \
+  RMD160_T(a, b, c, d, e, RMD160_G1, 10, 14, 15,  8); \
+  RMD160_T(e, a, b, c, d, RMD160_G1, 11, 15,  8, 11); \
+  RMD160_T(d, e, a, b, c, RMD160_G1, 12,  6,  1, 14); \
+  RMD160_T(c, d, e, a, b, RMD160_G1, 13,  7, 10, 14); \
+  RMD160_T(b, c, d, e, a, RMD160_G1, 14,  9,  3, 12); \
+  RMD160_T(a, b, c, d, e, RMD160_G1, 15,  8, 12,  6)
+
+#define RMD160_P2(a, b, c, d, e) \
+  RMD160_T(a, b, c, d, e, RMD160_G2,  7,  7,  6,  9); \
+  RMD160_T(e, a, b, c, d, RMD160_G2,  4,  6, 11, 13); \
+  RMD160_T(d, e, a, b, c, RMD160_G2, 13,  8,  3, 15); \
+  RMD160_T(c, d, e, a, b, RMD160_G2,  1, 13,  7,  7); \
+  RMD160_T(b, c, d, e, a, RMD160_G2, 10, 11,  0, 12); \
+  RMD160_T(a, b, c, d, e, RMD160_G2,  6,  9, 13,  8); \
+  RMD160_T(e, a, b, c, d, RMD160_G2, 15,  7,  5,  9); \
+  RMD160_T(d, e, a, b, c, RMD160_G2,  3, 15, 10, 11); \
+  RMD160_T(c, d, e, a, b, RMD160_G2, 12,  7, 14,  7); \
+  RMD160_T(b, c, d, e, a, RMD160_G2,  0, 12, 15,  7); \
+  RMD160_T(a, b, c, d, e, RMD160_G2,  9, 15,  8, 12); \
+  RMD160_T(e, a, b, c, d, RMD160_G2,  5,  9, 12,  7); \
+  RMD160_T(d, e, a, b, c, RMD160_G2,  2, 11,  4,  6); \
+  RMD160_T(c, d, e, a, b, RMD160_G2, 14,  7,  9, 15); \
+  RMD160_T(b, c, d, e, a, RMD160_G2, 11, 13,  1, 13); \
+  RMD160_T(a, b, c, d, e, RMD160_G2,  8, 12,  2, 11)
+
+#define RMD160_P3(a, b, c, d, e) \
+  RMD160_T(a, b, c, d, e, RMD160_G3,  3, 11, 15,  9); \
+  RMD160_T(e, a, b, c, d, RMD160_G3, 10, 13,  5,  7); \
+  RMD160_T(d, e, a, b, c, RMD160_G3, 14,  6,  1, 15); \
+  RMD160_T(c, d, e, a, b, RMD160_G3,  4,  7,  3, 11); \
+  RMD160_T(b, c, d, e, a, RMD160_G3,  9, 14,  7,  8); \
+  RMD160_T(a, b, c, d, e, RMD160_G3, 15,  9, 14,  6); \
+  RMD160_T(e, a, b, c, d, RMD160_G3,  8, 13,  6,  6); \
+  RMD160_T(d, e, a, b, c, RMD160_G3,  1, 15,  9, 14); \
+  RMD160_T(c, d, e, a, b, RMD160_G3,  2, 14, 11, 12); \
+  RMD160_T(b, c, d, e, a, RMD160_G3,  7,  8,  8, 13); \
+  RMD160_T(a, b, c, d, e, RMD160_G3,  0, 13, 12,  5); \
+  RMD160_T(e, a, b, c, d, RMD160_G3,  6,  6,  2, 14); \
+  RMD160_T(d, e, a, b, c, RMD160_G3, 13,  5, 10, 13); \
+  RMD160_T(c, d, e, a, b, RMD160_G3, 11, 12,  0, 13); \
+  RMD160_T(b, c, d, e, a, RMD160_G3,  5,  7,  4,  7); \
+  RMD160_T(a, b, c, d, e, RMD160_G3, 12,  5, 13,  5)
+
+#define RMD160_P4(a, b, c, d, e) \
+  RMD160_T(a, b, c, d, e, RMD160_G4,  1, 11,  8, 15); \
+  RMD160_T(e, a, b, c, d, RMD160_G4,  9, 12,  6,  5); \
+  RMD160_T(d, e, a, b, c, RMD160_G4, 11, 14,  4,  8); \
+  RMD160_T(c, d, e, a, b, RMD160_G4, 10, 15,  1, 11); \
+  RMD160_T(b, c, d, e, a, RMD160_G4,  0, 14,  3, 14); \
+  RMD160_T(a, b, c, d, e, RMD160_G4,  8, 15, 11, 14); \
+  RMD160_T(e, a, b, c, d, RMD160_G4, 12,  9, 15,  6); \
+  RMD160_T(d, e, a, b, c, RMD160_G4,  4,  8,  0, 14); \
+  RMD160_T(c, d, e, a, b, RMD160_G4, 13,  9,  5,  6); \
+  RMD160_T(b, c, d, e, a, RMD160_G4,  3, 14, 12,  9); \
+  RMD160_T(a, b, c, d, e, RMD160_G4,  7,  5,  2, 12); \
+  RMD160_T(e, a, b, c, d, RMD160_G4, 15,  6, 13,  9); \
+  RMD160_T(d, e, a, b, c, RMD160_G4, 14,  8,  9, 12); \
+  RMD160_T(c, d, e, a, b, RMD160_G4,  5,  6,  7,  5); \
+  RMD160_T(b, c, d, e, a, RMD160_G4,  6,  5, 10, 15); \
+  RMD160_T(a, b, c, d, e, RMD160_G4,  2, 12, 14,  8)
+
+#define RMD160_P5(a, b, c, d, e) \
+  RMD160_T(a, b, c, d, e, RMD160_G5,  4,  9, 12,  8); \
+  RMD160_T(e, a, b, c, d, RMD160_G5,  0, 15, 15,  5); \
+  RMD160_T(d, e, a, b, c, RMD160_G5,  5,  5, 10, 12); \
+  RMD160_T(c, d, e, a, b, RMD160_G5,  9, 11,  4,  9); \
+  RMD160_T(b, c, d, e, a, RMD160_G5,  7,  6,  1, 12); \
+  RMD160_T(a, b, c, d, e, RMD160_G5, 12,  8,  5,  5); \
+  RMD160_T(e, a, b, c, d, RMD160_G5,  2, 13,  8, 14); \
+  RMD160_T(d, e, a, b, c, RMD160_G5, 10, 12,  7,  6); \
+  RMD160_T(c, d, e, a, b, RMD160_G5, 14,  5,  6,  8); \
+  RMD160_T(b, c, d, e, a, RMD160_G5,  1, 12,  2, 13); \
+  RMD160_T(a, b, c, d, e, RMD160_G5,  3, 13, 13,  6); \
+  RMD160_T(e, a, b, c, d, RMD160_G5,  8, 14, 14,  5); \
+  RMD160_T(d, e, a, b, c, RMD160_G5, 11, 11,  0, 15); \
+  RMD160_T(c, d, e, a, b, RMD160_G5,  6,  8,  3, 13); \
+  RMD160_T(b, c, d, e, a, RMD160_G5, 15,  5,  9, 11); \
+  RMD160_T(a, b, c, d, e, RMD160_G5, 13,  6, 11, 11)
+
+/*
+ * Lane 0 takes the left function and lane 1 the right: with a lane select
+ * (0 left, all ones right) one ternary op each gives g(0, c, d) and
+ * g(1, c, d) ahead of time, and b, the word written by the step before,
+ * only picks between them.
+ * In rounds 1 and 5 both functions are b XOR a function of c and d, so b
+ * is XORed in, and round 3 has one function for both lanes.
+ * b is never the destination operand, so it is not copied first.
+ */
+#define RMD160_SEL _mm_set_epi32(0, 0, -1, 0)
+#define RMD160_G(b, c, d, p, q) \
+  _mm_ternarylogic_epi32(_mm_ternarylogic_epi32(RMD160_SEL, c, d, q), b, _mm_ternarylogic_epi32(RMD160_SEL, c, d, p), 0xe2)
+#define RMD160_G1(b, c, d) _mm_xor_si128(_mm_ternarylogic_epi32(RMD160_SEL, c, d, 0xd6), b) /* F1 | F5 */
+#define RMD160_G2(b, c, d) RMD160_G(b, c, d, 0x4a, 0xec)                                      /* F2 | F4 */
+#define RMD160_G3(b, c, d) _mm_ternarylogic_epi32(d, b, c, 0x2d)                              /* F3 | F3 */
+#define RMD160_G4(b, c, d) RMD160_G(b, c, d, 0xa4, 0xce)                                      /* F4 | F2 */
+#define RMD160_G5(b, c, d) _mm_xor_si128(_mm_ternarylogic_epi32(RMD160_SEL, c, d, 0x6d), b) /* F5 | F1 */
+
+/* message word xl plus the left constant, xr plus the right one */
+#define RMD160_W(xl, xr) \
+  _mm512_castsi512_si128(_mm512_permutex2var_epi32(wl, _mm512_zextsi128_si512(_mm_set_epi32(0, 0, 16 + xr, xl)), wr))
+#define RMD160_WK(kl, kr) \
+  wl = _mm512_add_epi32(w, _mm512_set1_epi32((int)(kl))); \
+  wr = _mm512_add_epi32(w, _mm512_set1_epi32((int)(kr)))
+
+/*
+ * One message with both lines in two lanes of one register, each step
+ * issued once for both: for single stream hashing, where there is nothing
+ * to batch and the step to step chain sets the pace.
+ */
+RMD160_AVX512VL static void
+rmd160mix2(
+  rmd160_bt h[]
+ ,const unsigned char x[]
+ ,size_t n
+){
+  __m512i w, wl, wr;
+  __m128i h0, h1, h2, h3, h4; /* chaining value in both lanes */
+  __m128i a, b, c, d, e;
+  __m128i f;
+
+  h0 = _mm_set1_epi32((int)h[0]);
+  h1 = _mm_set1_epi32((int)h[1]);
+  h2 = _mm_set1_epi32((int)h[2]);
+  h3 = _mm_set1_epi32((int)h[3]);
+  h4 = _mm_set1_epi32((int)h[4]);
+  for (; n; --n, x += 64) {
+    w = _mm512_loadu_si512((const void *)x); /* x86 is little endian */
+    a = h0;
+    b = h1;
+    c = h2;
+    d = h3;
+    e = h4;
+    RMD160_WK(0x00000000U, 0x50a28be6U);
+    RMD160_P1(a, b, c, d, e);
+    RMD160_WK(0x5a827999U, 0x5c4dd124U);
+    RMD160_P2(e, a, b, c, d);
+    RMD160_WK(0x6ed9eba1U, 0x6d703ef3U);
+    RMD160_P3(d, e, a, b, c);
+    RMD160_WK(0x8f1bbcdcU, 0x7a6d76e9U);
+    RMD160_P4(c, d, e, a, b);
+    RMD160_WK(0xa953fd4eU, 0x00000000U);
+    RMD160_P5(b, c, d, e, a);
+    /* left word plus the swapped right one, lane 0 to both */
+     f = _mm_shuffle_epi32(_mm_add_epi32(h1, _mm_add_epi32(c, _mm_shuffle_epi32(d, 0xe1))), 0x00);
+    h1 = _mm_shuffle_epi32(_mm_add_epi32(h2, _mm_add_epi32(d, _mm_shuffle_epi32(e, 0xe1))), 0x00);
+    h2 = _mm_shuffle_epi32(_mm_add_epi32(h3, _mm_add_epi32(e, _mm_shuffle_epi32(a, 0xe1))), 0x00);
+    h3 = _mm_shuffle_epi32(_mm_add_epi32(h4, _mm_add_epi32(a, _mm_shuffle_epi32(b, 0xe1))), 0x00);
+    h4 = _mm_shuffle_epi32(_mm_add_epi32(h0, _mm_add_epi32(b, _mm_shuffle_epi32(c, 0xe1))), 0x00);
+    h0 = f;
+  }
+  h[0] = (rmd160_bt)_mm_cvtsi128_si32(h0);
+  h[1] = (rmd160_bt)_mm_cvtsi128_si32(h1);
+  h[2] = (rmd160_bt)_mm_cvtsi128_si32(h2);
+  h[3] = (rmd160_bt)_mm_cvtsi128_si32(h3);
+  h[4] = (rmd160_bt)_mm_cvtsi128_si32(h4);
+}
+
+#endif /* (RMD160_UNROLL || RMD160_DISPATCH) && RMD160_AVX512VL */
+
+#ifdef RMD160_DISPATCH
+static void (*rmd160mix)(rmd160_bt [], const unsigned char [], size_t);
+#elif defined(RMD160_UNROLL) && defined(RMD160_AVX512VL)
+#define rmd160mix rmd160mix2
+#elif defined(RMD160_UNROLL)
+#define rmd160mix rmd160mixu
+#else
+#define rmd160mix rmd160mixl
+#endif
+
+/*
+ * Kernel levels, each a superset of the one before: rmd160mix is the
+ * unrolled kernel from "unroll" up (both lines in one AVX-512VL register
+ * at "avx512"), rmd160x8 runs AVX2 from "avx2" up and rmd160x16 runs
+ * AVX-512 at "avx512" (two AVX2 passes at "avx2").
+ * Without RMD160_DISPATCH the level is fixed by the compile flags.
+ */
+static const char *const rmd160kn[] = {
+  "loop"
+ ,"unroll"
+ ,"avx2"
+ ,"avx512"
+};
+
+/* index of kernel name k in rmd160kn, or the count if unknown */
+static unsigned int
+rmd160kfind(
+  const char *k
+){
+  unsigned int i;
+  unsigned int j;
+
+  for (i = 0; i < sizeof (rmd160kn) / sizeof (rmd160kn[0]); ++i) {
+    for (j = 0; k[j] && k[j] == rmd160kn[i][j]; ++j);
+    if (k[j] == rmd160kn[i][j])
+      break;
+  }
+  return (i);
+}
+
+#ifdef RMD160_DISPATCH
+
+static unsigned int rmd160kl; /* kernel level in use */
+#define RMD160_KL rmd160kl
+
+/* highest level this CPU can run */
+static unsigned int
+rmd160cpu(
+  void
+){
+#if defined(RMD160_AVX2) && defined(RMD160_AVX512F)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl"))
+    return (3);
+  if (__builtin_cpu_supports("avx2"))
+    return (2);
+#endif
+  return (1);
+}
+
+/* first use: RMD160_KERNEL from the environment, else the fastest */
+static void
+rmd160auto(
+  void
+){
+  const char *k;
+
+  if (!(k = getenv("RMD160_KERNEL")) || rmd160kernel(k))
+    rmd160kernel(0);
+}
+
+int
+rmd160kernel(
+  const char *k
+){
+  unsigned int i;
+
+  if (!k)
+    i = rmd160cpu();
+  else if ((i = rmd160kfind(k)) > rmd160cpu())
+    return (-1);
+  rmd160kl = i;
+#ifdef RMD160_AVX512VL
+  rmd160mix = i > 2 ? rmd160mix2 : i ? rmd160mixu : rmd160mixl;
+#else
+  rmd160mix = i ? rmd160mixu : rmd160mixl;
+#endif
+  return (0);
+}
+
+const char *
+rmd160kernelname(
+  void
+){
+  if (!rmd160mix)
+    rmd160auto();
+  return (rmd160kn[rmd160kl]);
+}
+
+#else /* RMD160_DISPATCH */
+
+#if defined(RMD160_AVX512F)
+#define RMD160_KL 3
+#elif defined(RMD160_AVX2)
+#define RMD160_KL 2
+#elif defined(RMD160_UNROLL)
+#define RMD160_KL 1
+#else
+#define RMD160_KL 0
+#endif
+
+int
+rmd160kernel(
+  const char *k
+){
+  if (k && rmd160kfind(k) != RMD160_KL)
+    return (-1);
+  return (0);
+}
+
+const char *
+rmd160kernelname(
+  void
+){
+  return (rmd160kn[RMD160_KL]);
+}
+
+#endif /* RMD160_DISPATCH */
+
 void
-rmd160update(
+rmd160init(
   rmd160_t *v
+){
+#ifdef RMD160_DISPATCH
+  if (!rmd160mix)
+    rmd160auto();
+#endif
+  v->h[0] = 0x67452301U;
+  v->h[1] = 0xefcdab89U;
+  v->h[2] = 0x98badcfeU;
+  v->h[3] = 0x10325476U;
+  v->h[4] = 0xc3d2e1f0U;
+  v->bh = v->bl = 0;
+  v->l = 0;
+}
+
+#ifdef RMD160_AVX2
+
+/* eight lanes of 32 bits */
+#define RMD160_ADD(x, y) _mm256_add_epi32(x, y)
+#define RMD160_ROL(x, n) _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - (n)))
+#define RMD160_K(k) _mm256_set1_epi32((int)(k))
+#define RMD160_NOT(x) _mm256_xor_si256(x, _mm256_set1_epi32(-1))
+#define RMD160_F1(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define RMD160_F2(x, y, z) _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)))
+#define RMD160_F3(x, y, z) _mm256_xor_si256(_mm256_or_si256(x, RMD160_NOT(y)), z)
+#define RMD160_F4(x, y, z) _mm256_xor_si256(y, _mm256_and_si256(z, _mm256_xor_si256(x, y)))
+#define RMD160_F5(x, y, z) _mm256_xor_si256(x, _mm256_or_si256(y, RMD160_NOT(z)))
+
+/* w[j] holds message word j of every lane's block */
+RMD160_AVX2 static void
+rmd160mix8(
+  __m256i h[]
+ ,const __m256i w[]
+){
+  __m256i al, bl, cl, dl, el;
+  __m256i ar, br, cr, dr, er;
+  __m256i f;
+
+  al = ar = h[0];
+  bl = br = h[1];
+  cl = cr = h[2];
+  dl = dr = h[3];
+  el = er = h[4];
+  RMD160_L1(al, bl, cl, dl, el);
+  RMD160_R1(ar, br, cr, dr, er);
+  RMD160_L2(el, al, bl, cl, dl);
+  RMD160_R2(er, ar, br, cr, dr);
+  RMD160_L3(dl, el, al, bl, cl);
+  RMD160_R3(dr, er, ar, br, cr);
+  RMD160_L4(cl, dl, el, al, bl);
+  RMD160_R4(cr, dr, er, ar, br);
+  RMD160_L5(bl, cl, dl, el, al);
+  RMD160_R5(br, cr, dr, er, ar);
+     f = RMD160_ADD(h[1], RMD160_ADD(cl, dr));
+  h[1] = RMD160_ADD(h[2], RMD160_ADD(dl, er));
+  h[2] = RMD160_ADD(h[3], RMD160_ADD(el, ar));
+  h[3] = RMD160_ADD(h[4], RMD160_ADD(al, br));
+  h[4] = RMD160_ADD(h[0], RMD160_ADD(bl, cr));
+  h[0] = f;
+}
+
+#undef RMD160_ADD
+#undef RMD160_ROL
+#undef RMD160_K
+#undef RMD160_NOT
+#undef RMD160_F1
+#undef RMD160_F2
+#undef RMD160_F3
+#undef RMD160_F4
+#undef RMD160_F5
+
+/* transpose a 64 byte block from each of eight lanes into w[16] */
+RMD160_AVX2 static void
+rmd160load8(
+  __m256i w[]
+ ,const unsigned char *const q[]
+){
+  __m256i r0, r1, r2, r3, r4, r5, r6, r7;
+  __m256i t0, t1, t2, t3, t4, t5, t6, t7;
+  unsigned int i;
+
+  for (i = 0; i < 64; i += 32, w += 8) {
+    r0 = _mm256_loadu_si256((const __m256i *)(q[0] + i));
+    r1 = _mm256_loadu_si256((const __m256i *)(q[1] + i));
+    r2 = _mm256_loadu_si256((const __m256i *)(q[2] + i));
+    r3 = _mm256_loadu_si256((const __m256i *)(q[3] + i));
+    r4 = _mm256_loadu_si256((const __m256i *)(q[4] + i));
+    r5 = _mm256_loadu_si256((const __m256i *)(q[5] + i));
+    r6 = _mm256_loadu_si256((const __m256i *)(q[6] + i));
+    r7 = _mm256_loadu_si256((const __m256i *)(q[7] + i));
+    t0 = _mm256_unpacklo_epi32(r0, r1);
+    t1 = _mm256_unpackhi_epi32(r0, r1);
+    t2 = _mm256_unpacklo_epi32(r2, r3);
+    t3 = _mm256_unpackhi_epi32(r2, r3);
+    t4 = _mm256_unpacklo_epi32(r4, r5);
+    t5 = _mm256_unpackhi_epi32(r4, r5);
+    t6 = _mm256_unpacklo_epi32(r6, r7);
+    t7 = _mm256_unpackhi_epi32(r6, r7);
+    r0 = _mm256_unpacklo_epi64(t0, t2);
+    r1 = _mm256_unpackhi_epi64(t0, t2);
+    r2 = _mm256_unpacklo_epi64(t1, t3);
+    r3 = _mm256_unpackhi_epi64(t1, t3);
+    r4 = _mm256_unpacklo_epi64(t4, t6);
+    r5 = _mm256_unpackhi_epi64(t4, t6);
+    r6 = _mm256_unpacklo_epi64(t5, t7);
+    r7 = _mm256_unpackhi_epi64(t5, t7);
+    w[0] = _mm256_permute2x128_si256(r0, r4, 0x20);
+    w[1] = _mm256_permute2x128_si256(r1, r5, 0x20);
+    w[2] = _mm256_permute2x128_si256(r2, r6, 0x20);
+    w[3] = _mm256_permute2x128_si256(r3, r7, 0x20);
+    w[4] = _mm256_permute2x128_si256(r0, r4, 0x31);
+    w[5] = _mm256_permute2x128_si256(r1, r5, 0x31);
+    w[6] = _mm256_permute2x128_si256(r2, r6, 0x31);
+    w[7] = _mm256_permute2x128_si256(r3, r7, 0x31);
+  }
+}
+
+#endif /* RMD160_AVX2 */
+
+#ifdef RMD160_AVX512F
+
+/* sixteen lanes of 32 bits, native rotate and three input logic */
+#define RMD160_ADD(x, y) _mm512_add_epi32(x, y)
+#define RMD160_ROL(x, n) _mm512_rol_epi32(x, n)
+#define RMD160_K(k) _mm512_set1_epi32((int)(k))
+#define RMD160_F1(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x96)
+#define RMD160_F2(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xca)
+#define RMD160_F3(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x59)
+#define RMD160_F4(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xe4)
+#define RMD160_F5(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x2d)
+
+/* w[j] holds message word j of every lane's block */
+RMD160_AVX512F static void
+rmd160mix16(
+  __m512i h[]
+ ,const __m512i w[]
+){
+  __m512i al, bl, cl, dl, el;
+  __m512i ar, br, cr, dr, er;
+  __m512i f;
+
+  al = ar = h[0];
+  bl = br = h[1];
+  cl = cr = h[2];
+  dl = dr = h[3];
+  el = er = h[4];
+  RMD160_L1(al, bl, cl, dl, el);
+  RMD160_R1(ar, br, cr, dr, er);
+  RMD160_L2(el, al, bl, cl, dl);
+  RMD160_R2(er, ar, br, cr, dr);
+  RMD160_L3(dl, el, al, bl, cl);
+  RMD160_R3(dr, er, ar, br, cr);
+  RMD160_L4(cl, dl, el, al, bl);
+  RMD160_R4(cr, dr, er, ar, br);
+  RMD160_L5(bl, cl, dl, el, al);
+  RMD160_R5(br, cr, dr, er, ar);
+     f = RMD160_ADD(h[1], RMD160_ADD(cl, dr));
+  h[1] = RMD160_ADD(h[2], RMD160_ADD(dl, er));
+  h[2] = RMD160_ADD(h[3], RMD160_ADD(el, ar));
+  h[3] = RMD160_ADD(h[4], RMD160_ADD(al, br));
+  h[4] = RMD160_ADD(h[0], RMD160_ADD(bl, cr));
+  h[0] = f;
+}
+
+#undef RMD160_ADD
+#undef RMD160_ROL
+#undef RMD160_K
+#undef RMD160_F1
+#undef RMD160_F2
+#undef RMD160_F3
+#undef RMD160_F4
+#undef RMD160_F5
+
+/* transpose a 64 byte block from each of sixteen lanes into w[16] */
+RMD160_AVX512F static void
+rmd160load16(
+  __m512i w[]
+ ,const unsigned char *const q[]
+){
+  __m512i r[16];
+  __m512i t[16];
+  unsigned int i;
+
+  for (i = 0; i < 16; ++i)
+    r[i] = _mm512_loadu_si512((const void *)q[i]);
+  for (i = 0; i < 16; i += 2) {
+    t[i] = _mm512_unpacklo_epi32(r[i], r[i + 1]);
+    t[i + 1] = _mm512_unpackhi_epi32(r[i], r[i + 1]);
+  }
+  for (i = 0; i < 16; i += 4) { /* r[i + k] quarter q holds word 4q+k of lanes i..i+3 */
+    r[i] = _mm512_unpacklo_epi64(t[i], t[i + 2]);
+    r[i + 1] = _mm512_unpackhi_epi64(t[i], t[i + 2]);
+    r[i + 2] = _mm512_unpacklo_epi64(t[i + 1], t[i + 3]);
+    r[i + 3] = _mm512_unpackhi_epi64(t[i + 1], t[i + 3]);
+  }
+  for (i = 0; i < 4; ++i) {
+    t[0] = _mm512_shuffle_i32x4(r[i], r[4 + i], 0x44);
+    t[1] = _mm512_shuffle_i32x4(r[i], r[4 + i], 0xee);
+    t[2] = _mm512_shuffle_i32x4(r[8 + i], r[12 + i], 0x44);
+    t[3] = _mm512_shuffle_i32x4(r[8 + i], r[12 + i], 0xee);
+    w[i] = _mm512_shuffle_i32x4(t[0], t[2], 0x88);
+    w[4 + i] = _mm512_shuffle_i32x4(t[0], t[2], 0xdd);
+    w[8 + i] = _mm512_shuffle_i32x4(t[1], t[3], 0x88);
+    w[12 + i] = _mm512_shuffle_i32x4(t[1], t[3], 0xdd);
+  }
+}
+
+#endif /* RMD160_AVX512F */
+
+static void
+rmd160len(
+  unsigned char *s
+ ,rmd160_bt bh
+ ,rmd160_bt bl
+){
+  /* bytes to bits * 8=2^3 */
+  *s++ = (unsigned char)(bl << 3);
+  *s++ = (unsigned char)(bl >> (1 * 8 - 3));
+  *s++ = (unsigned char)(bl >> (2 * 8 - 3));
+  *s++ = (unsigned char)(bl >> (3 * 8 - 3));
+  *s++ = (unsigned char)((bh << 3) | (bl >> (4 * 8 - 3)));
+  *s++ = (unsigned char)(bh >> (1 * 8 - 3));
+  *s++ = (unsigned char)(bh >> (2 * 8 - 3));
+  *s   = (unsigned char)(bh >> (3 * 8 - 3));
+}
+
+#if defined(RMD160_AVX2) || defined(RMD160_AVX512F)
+
+/* copy a short (< 64) tail into b[128] and pad it as rmd160final does */
+/* return the number of blocks (1 or 2) in b[] */
+static unsigned int
+rmd160tail(
+  unsigned char *b
  ,const unsigned char *d
  ,unsigned int l
+ ,rmd160_bt bh
+ ,rmd160_bt bl
+){
+  unsigned char *s;
+  unsigned int i;
+  unsigned int n;
+
+  for (i = 0, s = b; i < l; ++i, ++s, ++d)
+    *s = *d;
+  *s++ = 0x80;
+  n = ++i > 64 - 8 ? 128 : 64;
+  for (; i < n - 8; ++i, ++s)
+    *s = 0x00;
+  rmd160len(s, bh, bl);
+  return (n / 64);
+}
+
+#endif /* RMD160_AVX2 || RMD160_AVX512F */
+
+void
+rmd160updatez(
+  rmd160_t *v
+ ,const unsigned char *d
+ ,size_t l
 ){
   unsigned char *s;
 
@@ -159,7 +1026,7 @@ rmd160update(
     for (i = v->l, s = v->d + i; l && i < 64; --l, ++i, ++s, ++d)
       *s = *d;
     if (i == 64) {
-      rmd160mix(v->h, v->d);
+      rmd160mix(v->h, v->d, 1);
       if ((v->bl += 64) < 64)
         ++v->bh;
       v->l = 0;
@@ -168,18 +1035,107 @@ rmd160update(
       return;
     }
   }
-  for (; l >= 64; l -= 64, d += 64) {
-    rmd160mix(v->h, d);
-    if ((v->bl += 64) < 64)
+  if (l >= 64) {
+    size_t n;
+
+    n = l & ~(size_t)63;
+    rmd160mix(v->h, d, n / 64);
+    if ((v->bl += (rmd160_bt)n) < (rmd160_bt)n)
       ++v->bh;
+    v->bh += (rmd160_bt)(n >> 16 >> 16);
+    l -= n;
+    d += n;
   }
   if (l) {
-    v->l = l;
+    v->l = (unsigned int)l;
     for (s = v->d; l; --l, ++s, ++d)
       *s = *d;
   }
 }
 
+void
+rmd160update(
+  rmd160_t *v
+ ,const unsigned char *d
+ ,unsigned int l
+){
+  rmd160updatez(v, d, l);
+}
+
+void
+rmd160copy(
+  rmd160_t *v
+ ,const rmd160_t *s
+){
+  *v = *s;
+}
+
+/*
+ * Exported state, all little endian: "RMD160", version, pending bytes,
+ * the chaining value, the 64 bit count of bytes compressed and the pending
+ * bytes, zero filled to 64.
+ */
+static const unsigned char rmd160sm[6] = { 'R', 'M', 'D', '1', '6', '0' };
+#define RMD160_STATEV 1
+
+void
+rmd160export(
+  const rmd160_t *v
+ ,unsigned char *s
+){
+  unsigned int i;
+
+  for (i = 0; i < sizeof (rmd160sm); ++i)
+    *s++ = rmd160sm[i];
+  *s++ = RMD160_STATEV;
+  *s++ = (unsigned char)v->l;
+  for (i = 0; i < 5; ++i) {
+    *s++ = (unsigned char)(v->h[i] >> (0 * 8));
+    *s++ = (unsigned char)(v->h[i] >> (1 * 8));
+    *s++ = (unsigned char)(v->h[i] >> (2 * 8));
+    *s++ = (unsigned char)(v->h[i] >> (3 * 8));
+  }
+  for (i = 0; i < 4; ++i)
+    *s++ = (unsigned char)(v->bl >> (i * 8));
+  for (i = 0; i < 4; ++i)
+    *s++ = (unsigned char)(v->bh >> (i * 8));
+  for (i = 0; i < 64; ++i)
+    *s++ = i < v->l ? v->d[i] : 0x00;
+}
+
+int
+rmd160import(
+  rmd160_t *v
+ ,const unsigned char *s
+ ,unsigned long long *n
+){
+  rmd160_bt b[2];
+  unsigned int i;
+
+  for (i = 0; i < sizeof (rmd160sm); ++i)
+    if (s[i] != rmd160sm[i])
+      return (-1);
+  s += sizeof (rmd160sm);
+  if (*s++ != RMD160_STATEV || *s >= 64 || s[21] & 63)
+    return (-1);
+  for (i = *s + 1 + 20 + 8; i < RMD160_STATESZ - sizeof (rmd160sm) - 1; ++i)
+    if (s[i]) /* pending bytes are zero filled */
+      return (-1);
+  rmd160init(v);
+  v->l = *s++;
+  for (i = 0; i < 5; ++i, s += 4)
+    v->h[i] = (rmd160_bt)s[0] | (rmd160_bt)s[1] << 8 | (rmd160_bt)s[2] << 16 | (rmd160_bt)s[3] << 24;
+  for (i = 0; i < 2; ++i, s += 4)
+    b[i] = (rmd160_bt)s[0] | (rmd160_bt)s[1] << 8 | (rmd160_bt)s[2] << 16 | (rmd160_bt)s[3] << 24;
+  v->bl = b[0];
+  v->bh = b[1];
+  for (i = 0; i < v->l; ++i)
+    v->d[i] = s[i];
+  if (n)
+    *n = ((unsigned long long)v->bh << 16 << 16 | v->bl) + v->l;
+  return (0);
+}
+
 void
 rmd160final(
   rmd160_t *v
@@ -196,22 +1152,14 @@ rmd160final(
   if (i > 64 - 8) {
     for (; i < 64; ++i, ++s)
       *s = 0x00;
-    rmd160mix(v->h, v->d);
+    rmd160mix(v->h, v->d, 1);
     i = 0;
     s = v->d;
   }
   for (; i < 64 - 8; ++i, ++s)
     *s = 0x00;
-  /* bytes to bits * 8=2^3 */
-  *s++ = (unsigned char)(v->bl << 3);
-  *s++ = (unsigned char)(v->bl >> (1 * 8 - 3));
-  *s++ = (unsigned char)(v->bl >> (2 * 8 - 3));
-  *s++ = (unsigned char)(v->bl >> (3 * 8 - 3));
-  *s++ = (unsigned char)((v->bh << 3) | (v->bl >> (4 * 8 - 3)));
-  *s++ = (unsigned char)(v->bh >> (1 * 8 - 3));
-  *s++ = (unsigned char)(v->bh >> (2 * 8 - 3));
-  *s   = (unsigned char)(v->bh >> (3 * 8 - 3));
-  rmd160mix(v->h, v->d);
+  rmd160len(s, v->bh, v->bl);
+  rmd160mix(v->h, v->d, 1);
   for (i = 0; i < 5; ++i) {
     *h++ = (unsigned char)(v->h[i] >> (0 * 8));
     *h++ = (unsigned char)(v->h[i] >> (1 * 8));
@@ -220,146 +1168,1214 @@ rmd160final(
   }
 }
 
-void
-rmd160hmac(
-  const unsigned char *k
- ,unsigned int kl
- ,const unsigned char *d
- ,unsigned int dl
+/* wipe stack residue; volatile defeats dead-store elimination */
+static void
+rmd160wipe(
+  void *v
+ ,unsigned int l
+){
+  volatile unsigned char *p;
+
+  for (p = (volatile unsigned char *)v; l; --l)
+    *p++ = 0;
+}
+
+/* start v from the chaining value h with k bytes already compressed */
+static void
+rmd160resume(
+  rmd160_t *v
+ ,const rmd160_bt h[]
+ ,unsigned int k
+){
+  unsigned int i;
+
+  rmd160init(v);
+  for (i = 0; i < 5; ++i)
+    v->h[i] = h[i];
+  v->bl = k;
+}
+
+#ifdef RMD160_AVX2
+
+RMD160_AVX2 static void
+rmd160x8v(
+  const rmd160_bt *s
+ ,unsigned int k
+ ,const unsigned char *const *d
+ ,const unsigned int *l
  ,unsigned char *h
 ){
-  rmd160_t c;
-  unsigned char i[64];
-  unsigned char o[64];
-  unsigned int l;
+  unsigned char p[8][128];  /* padded tails */
+  const unsigned char *q[8];
+  rmd160_bt o[5][8];
+  unsigned int n[8];        /* whole blocks */
+  unsigned int t[8];        /* total blocks */
+  __m256i v[5];
+  __m256i u[5];
+  __m256i w[16];
+  __m256i e;
+  __m256i m;
+  unsigned int b;
+  unsigned int i;
+  unsigned int z;
 
-  if (kl > 64) {
-    rmd160init(&c);
-    rmd160update(&c, k, kl);
-    rmd160final(&c, h);
-    k = h;
-    kl = RMD160_SZ;
-  }
-  for (l = 0; l < kl; ++l) {
-    i[l] = *(k + l) ^ 0x36;
-    o[l] = *(k + l) ^ 0x5c;
+  for (z = 0, i = 0; i < 8; ++i) {
+    n[i] = l[i] / 64;
+    t[i] = n[i] + rmd160tail(p[i], d[i] + n[i] * 64, l[i] % 64, l[i] + k < k, l[i] + k);
+    if (t[i] > z)
+      z = t[i];
   }
-  for (; l < 64; ++l) {
-    i[l] = 0x00 ^ 0x36;
-    o[l] = 0x00 ^ 0x5c;
+  e = _mm256_loadu_si256((const __m256i *)t);
+  for (i = 0; i < 5; ++i)
+    v[i] = _mm256_set1_epi32((int)s[i]);
+  for (b = 0; b < z; ++b) {
+    for (i = 0; i < 8; ++i)
+      if (b < n[i])
+        q[i] = d[i] + b * 64;
+      else if (b < t[i])
+        q[i] = p[i] + (b - n[i]) * 64;
+      else
+        q[i] = p[i]; /* lane done, result discarded */
+    rmd160load8(w, q);
+    for (i = 0; i < 5; ++i)
+      u[i] = v[i];
+    rmd160mix8(u, w);
+    m = _mm256_cmpgt_epi32(e, _mm256_set1_epi32((int)b));
+    for (i = 0; i < 5; ++i)
+      v[i] = _mm256_blendv_epi8(v[i], u[i], m);
   }
-  rmd160init(&c);
-  rmd160update(&c, i, sizeof (i));
-  rmd160update(&c, d, dl);
-  rmd160final(&c, h);
-  rmd160init(&c);
-  rmd160update(&c, o, sizeof (o));
-  rmd160update(&c, h, RMD160_SZ);
-  rmd160final(&c, h);
-  /* wipe stack residue; volatile defeats dead-store elimination */
-  {
-    volatile unsigned char *p;
-    unsigned int n;
+  for (i = 0; i < 5; ++i)
+    _mm256_storeu_si256((__m256i *)o[i], v[i]);
+  for (b = 0; b < 8; ++b)
+    for (i = 0; i < 5; ++i) {
+      *h++ = (unsigned char)(o[i][b] >> (0 * 8));
+      *h++ = (unsigned char)(o[i][b] >> (1 * 8));
+      *h++ = (unsigned char)(o[i][b] >> (2 * 8));
+      *h++ = (unsigned char)(o[i][b] >> (3 * 8));
+    }
+}
+
+#endif /* RMD160_AVX2 */
+
+#ifdef RMD160_AVX512F
 
-    p = (volatile unsigned char *)&c;
-    for (n = 0; n < sizeof (c); ++n)
-      *p++ = 0;
-    p = (volatile unsigned char *)i;
-    for (n = 0; n < sizeof (i); ++n)
-      *p++ = 0;
-    p = (volatile unsigned char *)o;
-    for (n = 0; n < sizeof (o); ++n)
-      *p++ = 0;
+RMD160_AVX512F static void
+rmd160x16v(
+  const rmd160_bt *s
+ ,unsigned int k
+ ,const unsigned char *const *d
+ ,const unsigned int *l
+ ,unsigned char *h
+){
+  unsigned char p[16][128]; /* padded tails */
+  const unsigned char *q[16];
+  rmd160_bt o[5][16];
+  unsigned int n[16];       /* whole blocks */
+  unsigned int t[16];       /* total blocks */
+  __m512i v[5];
+  __m512i u[5];
+  __m512i w[16];
+  __m512i e;
+  unsigned int b;
+  unsigned int i;
+  unsigned int z;
+
+  for (z = 0, i = 0; i < 16; ++i) {
+    n[i] = l[i] / 64;
+    t[i] = n[i] + rmd160tail(p[i], d[i] + n[i] * 64, l[i] % 64, l[i] + k < k, l[i] + k);
+    if (t[i] > z)
+      z = t[i];
+  }
+  e = _mm512_loadu_si512((const void *)t);
+  for (i = 0; i < 5; ++i)
+    v[i] = _mm512_set1_epi32((int)s[i]);
+  for (b = 0; b < z; ++b) {
+    for (i = 0; i < 16; ++i)
+      if (b < n[i])
+        q[i] = d[i] + b * 64;
+      else if (b < t[i])
+        q[i] = p[i] + (b - n[i]) * 64;
+      else
+        q[i] = p[i]; /* lane done, result discarded */
+    rmd160load16(w, q);
+    for (i = 0; i < 5; ++i)
+      u[i] = v[i];
+    rmd160mix16(u, w);
+    for (i = 0; i < 5; ++i)
+      v[i] = _mm512_mask_mov_epi32(v[i], _mm512_cmpgt_epu32_mask(e, _mm512_set1_epi32((int)b)), u[i]);
+  }
+  for (i = 0; i < 5; ++i)
+    _mm512_storeu_si512((void *)o[i], v[i]);
+  for (b = 0; b < 16; ++b)
+    for (i = 0; i < 5; ++i) {
+      *h++ = (unsigned char)(o[i][b] >> (0 * 8));
+      *h++ = (unsigned char)(o[i][b] >> (1 * 8));
+      *h++ = (unsigned char)(o[i][b] >> (2 * 8));
+      *h++ = (unsigned char)(o[i][b] >> (3 * 8));
+    }
+}
+
+#endif /* RMD160_AVX512F */
+
+/* initial chaining value, as set by rmd160init */
+static const rmd160_bt rmd160iv[5] = {
+  0x67452301U
+ ,0xefcdab89U
+ ,0x98badcfeU
+ ,0x10325476U
+ ,0xc3d2e1f0U
+};
+
+/* n messages, each started from chaining value s with k bytes behind it */
+static void
+rmd160xn(
+  const rmd160_bt *s
+ ,unsigned int k
+ ,const unsigned char *const *d
+ ,const unsigned int *l
+ ,unsigned char *h
+ ,unsigned int n
+){
+  rmd160_t c;
+  unsigned int i;
+
+#ifdef RMD160_DISPATCH
+  if (!rmd160mix)
+    rmd160auto();
+#endif
+#ifdef RMD160_AVX512F
+  for (; RMD160_KL >= 3 && n >= 16; n -= 16, d += 16, l += 16, h += 16 * RMD160_SZ)
+    rmd160x16v(s, k, d, l, h);
+#endif
+#ifdef RMD160_AVX2
+  for (; RMD160_KL >= 2 && n >= 8; n -= 8, d += 8, l += 8, h += 8 * RMD160_SZ)
+    rmd160x8v(s, k, d, l, h);
+  if (RMD160_KL >= 2 && n > 2) { /* fill the idle lanes with the first message */
+    const unsigned char *e[8];
+    unsigned int f[8];
+    unsigned char g[8 * RMD160_SZ];
+
+    for (i = 0; i < 8; ++i) {
+      e[i] = d[i < n ? i : 0];
+      f[i] = l[i < n ? i : 0];
+    }
+    rmd160x8v(s, k, e, f, g);
+    for (i = 0; i < n * RMD160_SZ; ++i)
+      h[i] = g[i];
+    return;
+  }
+#endif
+  for (i = 0; i < n; ++i, h += RMD160_SZ) {
+    rmd160resume(&c, s, k);
+    rmd160update(&c, d[i], l[i]);
+    rmd160final(&c, h);
   }
 }
 
 void
-rmd160hkdf(
-  const unsigned char *k
- ,unsigned int kl
+rmd160x8(
+  const unsigned char *const *d
+ ,const unsigned int *l
+ ,unsigned char *h
+){
+  rmd160xn(rmd160iv, 0, d, l, h, 8);
+}
+
+void
+rmd160x16(
+  const unsigned char *const *d
+ ,const unsigned int *l
+ ,unsigned char *h
+){
+  rmd160xn(rmd160iv, 0, d, l, h, 16);
+}
+
+void
+rmd160n(
+  unsigned int n
+ ,const unsigned char *const *d
+ ,const unsigned int *l
+ ,unsigned char *h
+){
+  unsigned int g;
+
+  for (; n; n -= g, d += g, l += g, h += g * RMD160_SZ) {
+    g = n < 16 ? n : 16;
+    rmd160xn(rmd160iv, 0, d, l, h, g);
+  }
+}
+
+/*
+ * One call over a message already in memory: whole blocks are compressed
+ * straight from it and only the tail is padded, in one or two blocks on
+ * the stack, with no context.
+ */
+static void
+rmd160fix(
+  const unsigned char *d
+ ,size_t l
+ ,unsigned char *h
+){
+  unsigned char b[128];
+  rmd160_bt s[5];
+  size_t k;
+  unsigned int t;
+  unsigned int n;
+  unsigned int i;
+
+#ifdef RMD160_DISPATCH
+  if (!rmd160mix)
+    rmd160auto();
+#endif
+  for (i = 0; i < 5; ++i)
+    s[i] = rmd160iv[i];
+  if ((k = l & ~(size_t)63)) {
+    rmd160mix(s, d, k / 64);
+    d += k;
+  }
+  t = (unsigned int)(l - k);
+  n = t < 64 - 8 ? 64 : 128;
+  for (i = 0; i < t; ++i)
+    b[i] = d[i];
+  b[i++] = 0x80;
+  for (; i < n - 8; ++i)
+    b[i] = 0x00;
+  rmd160len(b + n - 8, (rmd160_bt)(l >> 16 >> 16), (rmd160_bt)l);
+  rmd160mix(s, b, n / 64);
+  for (i = 0; i < 5; ++i) {
+    *h++ = (unsigned char)(s[i] >> (0 * 8));
+    *h++ = (unsigned char)(s[i] >> (1 * 8));
+    *h++ = (unsigned char)(s[i] >> (2 * 8));
+    *h++ = (unsigned char)(s[i] >> (3 * 8));
+  }
+}
+
+void
+rmd160(
+  const unsigned char *d
+ ,size_t l
+ ,unsigned char *h
+){
+  rmd160fix(d, l, h);
+}
+
+/*
+ * The fixed lengths: the message over a zeroed block, the 0x80 and the
+ * bit length (little endian) stored as constants, and the n padded
+ * blocks compressed from the IV in one call.
+ */
+static void
+rmd160fixb(
+  const unsigned char *b
+ ,unsigned int n
+ ,unsigned char *h
+){
+  rmd160_bt s[5];
+  unsigned int i;
+
+#ifdef RMD160_DISPATCH
+  if (!rmd160mix)
+    rmd160auto();
+#endif
+  for (i = 0; i < 5; ++i)
+    s[i] = rmd160iv[i];
+  rmd160mix(s, b, n);
+  for (i = 0; i < 5; ++i) {
+    *h++ = (unsigned char)(s[i] >> (0 * 8));
+    *h++ = (unsigned char)(s[i] >> (1 * 8));
+    *h++ = (unsigned char)(s[i] >> (2 * 8));
+    *h++ = (unsigned char)(s[i] >> (3 * 8));
+  }
+}
+
+void
+rmd160fix20(
+  const unsigned char *d
+ ,unsigned char *h
+){
+  unsigned char b[64] = { 0 };
+  unsigned int i;
+
+  for (i = 0; i < 20; ++i)
+    b[i] = d[i];
+  b[20] = 0x80;
+  b[56] = (unsigned char)(20 * 8); /* bit length */
+  b[57] = 20 * 8 >> 8;
+  rmd160fixb(b, 1, h);
+}
+
+void
+rmd160fix32(
+  const unsigned char *d
+ ,unsigned char *h
+){
+  unsigned char b[64] = { 0 };
+  unsigned int i;
+
+  for (i = 0; i < 32; ++i)
+    b[i] = d[i];
+  b[32] = 0x80;
+  b[56] = (unsigned char)(32 * 8); /* bit length */
+  b[57] = 32 * 8 >> 8;
+  rmd160fixb(b, 1, h);
+}
+
+void
+rmd160fix33(
+  const unsigned char *d
+ ,unsigned char *h
+){
+  unsigned char b[64] = { 0 };
+  unsigned int i;
+
+  for (i = 0; i < 33; ++i)
+    b[i] = d[i];
+  b[33] = 0x80;
+  b[56] = (unsigned char)(33 * 8); /* bit length */
+  b[57] = 33 * 8 >> 8;
+  rmd160fixb(b, 1, h);
+}
+
+void
+rmd160fix65(
+  const unsigned char *d
+ ,unsigned char *h
+){
+  unsigned char b[128] = { 0 };
+  unsigned int i;
+
+  for (i = 0; i < 65; ++i)
+    b[i] = d[i];
+  b[65] = 0x80;
+  b[120] = (unsigned char)(65 * 8); /* bit length */
+  b[121] = 65 * 8 >> 8;
+  rmd160fixb(b, 2, h);
+}
+
+/* n messages of l bytes laid end to end, through the batch lanes */
+void
+rmd160fixn(
+  unsigned int n
+ ,unsigned int l
  ,const unsigned char *d
- ,unsigned int dl
- ,unsigned char *s
- ,unsigned int sl
+ ,unsigned char *h
+){
+  const unsigned char *q[16];
+  unsigned int ql[16];
+  unsigned int g;
+  unsigned int i;
+
+  for (; n; n -= g, h += g * RMD160_SZ) {
+    g = n < 16 ? n : 16;
+    for (i = 0; i < g; ++i, d += l) {
+      q[i] = d;
+      ql[i] = l;
+    }
+    rmd160xn(rmd160iv, 0, q, ql, h, g);
+  }
+}
+
+struct rmd160pfx {
+  rmd160_t c;           /* after the prefix */
+};
+
+unsigned int
+rmd160pfxtsize(
+  void
+){
+  return (sizeof (rmd160pfx_t));
+}
+
+void
+rmd160pfxinit(
+  rmd160pfx_t *v
+ ,const unsigned char *p
+ ,size_t pl
+){
+  rmd160init(&v->c);
+  rmd160updatez(&v->c, p, pl);
+}
+
+void
+rmd160pfxstart(
+  const rmd160pfx_t *v
+ ,rmd160_t *c
+){
+  *c = v->c;
+}
+
+void
+rmd160pfx(
+  const rmd160pfx_t *v
+ ,const unsigned char *d
+ ,size_t dl
+ ,unsigned char *h
 ){
   rmd160_t c;
-  unsigned char i[64];
-  unsigned char o[64];
+
+  c = v->c;
+  rmd160updatez(&c, d, dl);
+  rmd160final(&c, h);
+}
+
+void
+rmd160pfxn(
+  const rmd160pfx_t *v
+ ,unsigned int n
+ ,const unsigned char *const *d
+ ,const unsigned int *dl
+ ,unsigned char *h
+){
+  unsigned int g;
+
+  if (v->c.l || v->c.bh) { /* the lanes start on a block boundary, under 4 GiB in */
+    for (; n; --n, ++d, ++dl, h += RMD160_SZ)
+      rmd160pfx(v, *d, *dl, h);
+    return;
+  }
+  for (; n; n -= g, d += g, dl += g, h += g * RMD160_SZ) {
+    g = n < 16 ? n : 16;
+    rmd160xn(v->c.h, v->c.bl, d, dl, h, g);
+  }
+}
+
+struct rmd160hkey {
+  rmd160_bt i[5];       /* chaining value after the ipad block */
+  rmd160_bt o[5];       /* chaining value after the opad block */
+};
+
+unsigned int
+rmd160hkeytsize(
+  void
+){
+  return (sizeof (rmd160hkey_t));
+}
+
+static void
+rmd160hkeyz(
+  rmd160hkey_t *v
+ ,const unsigned char *k
+ ,size_t kl
+){
+  rmd160_t c;
+  unsigned char p[64];
   unsigned char t[RMD160_SZ];
-  unsigned char t2[RMD160_SZ];
   unsigned int l;
-  unsigned int n;
 
-  if (sl > 255 * RMD160_SZ)
-    sl = 255 * RMD160_SZ;
   if (kl > 64) {
     rmd160init(&c);
-    rmd160update(&c, k, kl);
+    rmd160updatez(&c, k, kl);
     rmd160final(&c, t);
     k = t;
     kl = RMD160_SZ;
   }
-  for (l = 0; l < kl; ++l) {
-    i[l] = *(k + l) ^ 0x36;
-    o[l] = *(k + l) ^ 0x5c;
-  }
-  for (; l < 64; ++l) {
-    i[l] = 0x00 ^ 0x36;
-    o[l] = 0x00 ^ 0x5c;
+  for (l = 0; l < kl; ++l)
+    p[l] = *(k + l) ^ 0x36;
+  for (; l < 64; ++l)
+    p[l] = 0x00 ^ 0x36;
+  rmd160init(&c);
+  rmd160mix(c.h, p, 1);
+  for (l = 0; l < 5; ++l)
+    v->i[l] = c.h[l];
+  for (l = 0; l < 64; ++l)
+    p[l] ^= 0x36 ^ 0x5c;
+  rmd160init(&c);
+  rmd160mix(c.h, p, 1);
+  for (l = 0; l < 5; ++l)
+    v->o[l] = c.h[l];
+  rmd160wipe(&c, sizeof (c));
+  rmd160wipe(p, sizeof (p));
+  rmd160wipe(t, sizeof (t));
+}
+
+void
+rmd160hkeyinit(
+  rmd160hkey_t *v
+ ,const unsigned char *k
+ ,unsigned int kl
+){
+  rmd160hkeyz(v, k, kl);
+}
+
+struct rmd160hmac {
+  rmd160_t c;           /* inner hash */
+  rmd160_bt o[5];       /* chaining value after the opad block */
+};
+
+unsigned int
+rmd160hmactsize(
+  void
+){
+  return (sizeof (rmd160hmac_t));
+}
+
+void
+rmd160hmacstart(
+  rmd160hmac_t *v
+ ,const rmd160hkey_t *k
+){
+  unsigned int i;
+
+  rmd160resume(&v->c, k->i, 64);
+  for (i = 0; i < 5; ++i)
+    v->o[i] = k->o[i];
+}
+
+void
+rmd160hmacinit(
+  rmd160hmac_t *v
+ ,const unsigned char *k
+ ,unsigned int kl
+){
+  rmd160hkey_t s;
+
+  rmd160hkeyz(&s, k, kl);
+  rmd160hmacstart(v, &s);
+  rmd160wipe(&s, sizeof (s));
+}
+
+void
+rmd160hmacupdatez(
+  rmd160hmac_t *v
+ ,const unsigned char *d
+ ,size_t l
+){
+  rmd160updatez(&v->c, d, l);
+}
+
+void
+rmd160hmacupdate(
+  rmd160hmac_t *v
+ ,const unsigned char *d
+ ,unsigned int l
+){
+  rmd160updatez(&v->c, d, l);
+}
+
+void
+rmd160hmacfinal(
+  rmd160hmac_t *v
+ ,unsigned char *h
+){
+  rmd160final(&v->c, h);
+  rmd160resume(&v->c, v->o, 64);
+  rmd160update(&v->c, h, RMD160_SZ);
+  rmd160final(&v->c, h);
+  rmd160wipe(v, sizeof (*v));
+}
+
+void
+rmd160hkeymacz(
+  const rmd160hkey_t *v
+ ,const unsigned char *d
+ ,size_t dl
+ ,unsigned char *h
+){
+  rmd160hmac_t c;
+
+  rmd160hmacstart(&c, v);
+  rmd160hmacupdatez(&c, d, dl);
+  rmd160hmacfinal(&c, h);
+}
+
+void
+rmd160hkeymac(
+  const rmd160hkey_t *v
+ ,const unsigned char *d
+ ,unsigned int dl
+ ,unsigned char *h
+){
+  rmd160hkeymacz(v, d, dl, h);
+}
+
+/* n messages under one key schedule, run through the batch lanes */
+void
+rmd160hkeymacn(
+  const rmd160hkey_t *v
+ ,unsigned int n
+ ,const unsigned char *const *d
+ ,const unsigned int *dl
+ ,unsigned char *h
+){
+  unsigned char t[16][RMD160_SZ];  /* inner hash of each lane */
+  const unsigned char *q[16];
+  unsigned int ql[16];
+  unsigned int g;
+  unsigned int i;
+
+  for (; n; n -= g, d += g, dl += g, h += g * RMD160_SZ) {
+    g = n < 16 ? n : 16;
+    rmd160xn(v->i, 64, d, dl, t[0], g);
+    for (i = 0; i < g; ++i) {
+      q[i] = t[i];
+      ql[i] = RMD160_SZ;
+    }
+    rmd160xn(v->o, 64, q, ql, h, g);
   }
+  rmd160wipe(t, sizeof (t));
+}
+
+void
+rmd160hmacz(
+  const unsigned char *k
+ ,size_t kl
+ ,const unsigned char *d
+ ,size_t dl
+ ,unsigned char *h
+){
+  rmd160hkey_t v;
+
+  rmd160hkeyz(&v, k, kl);
+  rmd160hkeymacz(&v, d, dl, h);
+  rmd160wipe(&v, sizeof (v));
+}
+
+void
+rmd160hmac(
+  const unsigned char *k
+ ,unsigned int kl
+ ,const unsigned char *d
+ ,unsigned int dl
+ ,unsigned char *h
+){
+  rmd160hmacz(k, kl, d, dl, h);
+}
+
+/* HKDF-Expand from a key schedule of the PRK: each T(n) starts from its midstates */
+void
+rmd160hkeyhkdfz(
+  const rmd160hkey_t *v
+ ,const unsigned char *d
+ ,size_t dl
+ ,unsigned char *s
+ ,unsigned int sl
+){
+  rmd160hmac_t c;
+  unsigned char t[RMD160_SZ];
+  unsigned int l;
+  unsigned int n;
+
+  if (sl > 255 * RMD160_SZ)
+    sl = 255 * RMD160_SZ;
   for (n = 0, l = 0; l < sl;) {
     unsigned char b;
     unsigned int j;
 
     b = (unsigned char)++n;
-    rmd160init(&c);
-    rmd160update(&c, i, sizeof (i));
+    rmd160hmacstart(&c, v);
     if (n > 1)
-      rmd160update(&c, t, RMD160_SZ);
-    rmd160update(&c, d, dl);
-    rmd160update(&c, &b, 1);
-    rmd160final(&c, t2);
-    rmd160init(&c);
-    rmd160update(&c, o, sizeof (o));
-    rmd160update(&c, t2, RMD160_SZ);
-    rmd160final(&c, t);
+      rmd160hmacupdate(&c, t, RMD160_SZ);
+    rmd160hmacupdatez(&c, d, dl);
+    rmd160hmacupdate(&c, &b, 1);
+    rmd160hmacfinal(&c, t);
     for (j = 0; j < RMD160_SZ && l < sl; ++j, ++l)
       s[l] = t[j];
   }
-  /* wipe stack residue once; volatile defeats dead-store elimination */
-  {
-    volatile unsigned char *p;
-    unsigned int m;
+  rmd160wipe(t, sizeof (t));
+}
+
+void
+rmd160hkeyhkdf(
+  const rmd160hkey_t *v
+ ,const unsigned char *d
+ ,unsigned int dl
+ ,unsigned char *s
+ ,unsigned int sl
+){
+  rmd160hkeyhkdfz(v, d, dl, s, sl);
+}
 
-    p = (volatile unsigned char *)&c;
-    for (m = 0; m < sizeof (c); ++m)
-      *p++ = 0;
-    p = (volatile unsigned char *)i;
-    for (m = 0; m < sizeof (i); ++m)
-      *p++ = 0;
-    p = (volatile unsigned char *)o;
-    for (m = 0; m < sizeof (o); ++m)
-      *p++ = 0;
-    p = (volatile unsigned char *)t;
-    for (m = 0; m < sizeof (t); ++m)
-      *p++ = 0;
-    p = (volatile unsigned char *)t2;
-    for (m = 0; m < sizeof (t2); ++m)
-      *p++ = 0;
+/* HKDF-Expand of n infos under one key schedule, ol bytes into each o[i] */
+void
+rmd160hkeyhkdfn(
+  const rmd160hkey_t *v
+ ,unsigned int n
+ ,const unsigned char *const *d
+ ,const unsigned int *dl
+ ,unsigned char *const *o
+ ,unsigned int ol
+){
+  unsigned char m[16][128];        /* T(n-1) | info | counter of each lane */
+  unsigned char t[16][RMD160_SZ];  /* inner hash of each lane */
+  unsigned char u[16][RMD160_SZ];  /* T(n) of each lane */
+  const unsigned char *q[16];
+  unsigned int ql[16];
+  unsigned int x[16];              /* info of each lane */
+  unsigned int g;
+  unsigned int i;
+  unsigned int j;
+  unsigned int k;
+  unsigned int l;
+  unsigned char b;
+
+  if (ol > 255 * RMD160_SZ)
+    ol = 255 * RMD160_SZ;
+  for (i = 0; i < n;) {
+    for (g = 0; g < 16 && i < n; ++i)
+      if (dl[i] < sizeof (m[0]) - RMD160_SZ)
+        x[g++] = i;
+      else /* too long to stage in a lane */
+        rmd160hkeyhkdf(v, d[i], dl[i], o[i], ol);
+    for (b = 1, l = 0; l < ol; ++b, l += RMD160_SZ) {
+      for (j = 0; j < g; ++j) {
+        unsigned char *s;
+
+        s = m[j];
+        if (b > 1)
+          for (k = 0; k < RMD160_SZ; ++k)
+            *s++ = u[j][k];
+        for (k = 0; k < dl[x[j]]; ++k)
+          *s++ = d[x[j]][k];
+        *s++ = b;
+        q[j] = m[j];
+        ql[j] = (unsigned int)(s - m[j]);
+      }
+      rmd160xn(v->i, 64, q, ql, t[0], g);
+      for (j = 0; j < g; ++j) {
+        q[j] = t[j];
+        ql[j] = RMD160_SZ;
+      }
+      rmd160xn(v->o, 64, q, ql, u[0], g);
+      for (j = 0; j < g; ++j)
+        for (k = 0; k < RMD160_SZ && l + k < ol; ++k)
+          o[x[j]][l + k] = u[j][k];
+    }
   }
+  rmd160wipe(m, sizeof (m));
+  rmd160wipe(t, sizeof (t));
+  rmd160wipe(u, sizeof (u));
 }
 
 void
-rmd160hex(
-  const unsigned char *h
- ,char *o
+rmd160hkdfextract(
+  const unsigned char *s
+ ,unsigned int sl
+ ,const unsigned char *k
+ ,unsigned int kl
+ ,unsigned char *h
+){
+  rmd160hmac(s, sl, k, kl, h);
+}
+
+void
+rmd160hkdfz(
+  const unsigned char *k
+ ,size_t kl
+ ,const unsigned char *d
+ ,size_t dl
+ ,unsigned char *s
+ ,unsigned int sl
+){
+  rmd160hkey_t v;
+
+  rmd160hkeyz(&v, k, kl);
+  rmd160hkeyhkdfz(&v, d, dl, s, sl);
+  rmd160wipe(&v, sizeof (v));
+}
+
+void
+rmd160hkdf(
+  const unsigned char *k
+ ,unsigned int kl
+ ,const unsigned char *d
+ ,unsigned int dl
+ ,unsigned char *s
+ ,unsigned int sl
+){
+  rmd160hkdfz(k, kl, d, dl, s, sl);
+}
+
+/*
+ * Tree hash: the input is cut into RMD160_CHUNK byte chunks (the last one
+ * shorter, an empty input one empty chunk) and
+ *  leaf = RIPEMD-160(L | chunk)
+ *  node = RIPEMD-160(N | left | right)
+ * where L is a 64 byte block of 0x00 and N is 0x01 followed by 63 0x00.
+ * Leaves are paired left to right a level at a time, an odd node at the end
+ * of a level moves up unpaired, until one node, the root, remains.
+ * The prefixes fill a block so every leaf and node starts from a cached
+ * midstate and the chunks stay block aligned for the batch lanes.
+ */
+
+struct rmd160tree {
+  rmd160_t c;           /* current leaf */
+  rmd160_bt m[5];       /* chaining value after L */
+  size_t n;             /* leaves done */
+  size_t f;             /* bytes in the current leaf */
+  unsigned int d;       /* subtrees on the stack */
+  unsigned char s[sizeof (size_t) * 8][RMD160_SZ]; /* complete subtrees, largest first */
+};
+
+unsigned int
+rmd160treetsize(
+  void
+){
+  return (sizeof (rmd160tree_t));
+}
+
+/* chaining value after the prefix block of a leaf (0x00) or node (0x01) */
+static void
+rmd160treemid(
+  rmd160_bt s[]
+ ,unsigned char b
 ){
+  rmd160_t c;
+  unsigned char p[64];
   unsigned int i;
 
-  for (i = 0; i < RMD160_SZ; ++i, ++h) {
-    static const char m[] = "0123456789abcdef";
+  p[0] = b;
+  for (i = 1; i < 64; ++i)
+    p[i] = 0x00;
+  rmd160init(&c);
+  rmd160mix(c.h, p, 1);
+  for (i = 0; i < 5; ++i)
+    s[i] = c.h[i];
+}
 
+void
+rmd160treeleafn(
+  unsigned int n
+ ,const unsigned char *const *d
+ ,const unsigned int *l
+ ,unsigned char *h
+){
+  rmd160_bt s[5];
+
+  rmd160treemid(s, 0x00);
+  rmd160xn(s, 64, d, l, h, n);
+}
+
+/* n adjacent (left, right) pairs, through the batch lanes */
+void
+rmd160treenoden(
+  unsigned int n
+ ,const unsigned char *p
+ ,unsigned char *h
+){
+  rmd160_bt s[5];
+  const unsigned char *q[16];
+  unsigned int ql[16];
+  unsigned int g;
+  unsigned int j;
+
+  rmd160treemid(s, 0x01);
+  for (; n; n -= g, p += g * 2 * RMD160_SZ, h += g * RMD160_SZ) {
+    g = n < 16 ? n : 16;
+    for (j = 0; j < g; ++j) {
+      q[j] = p + j * 2 * RMD160_SZ;
+      ql[j] = 2 * RMD160_SZ;
+    }
+    rmd160xn(s, 64, q, ql, h, g);
+  }
+}
+
+void
+rmd160treenode(
+  const unsigned char *l
+ ,const unsigned char *r
+ ,unsigned char *h
+){
+  unsigned char t[2 * RMD160_SZ];
+  unsigned int i;
+
+  for (i = 0; i < RMD160_SZ; ++i) {
+    t[i] = l[i];
+    t[RMD160_SZ + i] = r[i];
+  }
+  rmd160treenoden(1, t, h);
+}
+
+void
+rmd160treeroot(
+  unsigned char *a
+ ,size_t n
+ ,unsigned char *h
+){
+  unsigned char t[16][RMD160_SZ];
+  const unsigned char *q;
+  unsigned int ql;
+  size_t m;
+  size_t i;
+  unsigned int g;
+  unsigned int j;
+  unsigned int k;
+
+  if (!n) { /* no chunks is one empty leaf */
+    q = a;
+    ql = 0;
+    rmd160treeleafn(1, &q, &ql, h);
+    return;
+  }
+  for (; n > 1; n = m + (n & 1)) {
+    m = n / 2;
+    for (i = 0; i < m; i += g) {
+      g = m - i < 16 ? (unsigned int)(m - i) : 16;
+      rmd160treenoden(g, a + i * 2 * RMD160_SZ, t[0]);
+      for (j = 0; j < g; ++j) /* behind every pair still to be read */
+        for (k = 0; k < RMD160_SZ; ++k)
+          a[(i + j) * RMD160_SZ + k] = t[j][k];
+    }
+    if (n & 1)
+      for (j = 0; j < RMD160_SZ; ++j)
+        a[m * RMD160_SZ + j] = a[(n - 1) * RMD160_SZ + j];
+  }
+  for (j = 0; j < RMD160_SZ; ++j)
+    h[j] = a[j];
+}
+
+void
+rmd160treeinit(
+  rmd160tree_t *v
+){
+  rmd160treemid(v->m, 0x00);
+  rmd160resume(&v->c, v->m, 64);
+  v->n = v->f = 0;
+  v->d = 0;
+}
+
+/* add a leaf, merging the equal sized subtrees it completes */
+static void
+rmd160treepush(
+  rmd160tree_t *v
+ ,const unsigned char *h
+){
+  size_t m;
+  unsigned int i;
+
+  for (i = 0; i < RMD160_SZ; ++i)
+    v->s[v->d][i] = h[i];
+  ++v->d;
+  for (m = ++v->n; !(m & 1); m >>= 1, --v->d)
+    rmd160treenode(v->s[v->d - 2], v->s[v->d - 1], v->s[v->d - 2]);
+}
+
+void
+rmd160treeupdate(
+  rmd160tree_t *v
+ ,const unsigned char *d
+ ,size_t l
+){
+  unsigned char t[16][RMD160_SZ];
+  const unsigned char *q[16];
+  unsigned int ql[16];
+  size_t k;
+  unsigned int g;
+  unsigned int i;
+
+  while (l) {
+    if (!v->f && l >= RMD160_CHUNK) { /* whole chunks through the batch lanes */
+      for (g = 0; g < 16 && l >= RMD160_CHUNK; ++g, d += RMD160_CHUNK, l -= RMD160_CHUNK) {
+        q[g] = d;
+        ql[g] = RMD160_CHUNK;
+      }
+      rmd160treeleafn(g, q, ql, t[0]);
+      for (i = 0; i < g; ++i)
+        rmd160treepush(v, t[i]);
+      continue;
+    }
+    k = RMD160_CHUNK - v->f < l ? RMD160_CHUNK - v->f : l;
+    rmd160updatez(&v->c, d, k);
+    v->f += k;
+    d += k;
+    l -= k;
+    if (v->f == RMD160_CHUNK) {
+      rmd160final(&v->c, t[0]);
+      rmd160treepush(v, t[0]);
+      rmd160resume(&v->c, v->m, 64);
+      v->f = 0;
+    }
+  }
+}
+
+void
+rmd160treefinal(
+  rmd160tree_t *v
+ ,unsigned char *h
+){
+  unsigned int i;
+
+  if (v->f || !v->n) {
+    rmd160final(&v->c, h);
+    rmd160treepush(v, h);
+  }
+  for (; v->d > 1; --v->d)
+    rmd160treenode(v->s[v->d - 2], v->s[v->d - 1], v->s[v->d - 2]);
+  for (i = 0; i < RMD160_SZ; ++i)
+    h[i] = v->s[0][i];
+}
+
+void
+rmd160tree(
+  const unsigned char *d
+ ,size_t l
+ ,unsigned char *h
+){
+  rmd160tree_t v;
+
+  rmd160treeinit(&v);
+  rmd160treeupdate(&v, d, l);
+  rmd160treefinal(&v, h);
+}
+
+/* n bytes to 2 * n hex characters */
+static void
+rmd160hexs(
+  const unsigned char *h
+ ,char *o
+ ,unsigned int n
+){
+  static const char m[] = "0123456789abcdef";
+
+  for (; n; --n, ++h) {
     *o++ = m[(*h >> 4) & 0xf];
     *o++ = m[(*h >> 0) & 0xf];
   }
 }
+
+/* 2 * n hex characters (either case) to n bytes: -1, else the offset of the first bad one */
+static int
+rmd160unhexs(
+  const char *s
+ ,unsigned char *h
+ ,unsigned int n
+){
+  unsigned int i;
+  unsigned int v;
+  int c;
+
+  for (i = 0, v = 0; i < 2 * n; ++i) {
+    c = (unsigned char)s[i];
+    if (c >= '0' && c <= '9')
+      c -= '0';
+    else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+      c = (c | 0x20) - 'a' + 10;
+    else
+      return ((int)i);
+    v = v << 4 | (unsigned int)c;
+    if (i & 1)
+      *h++ = (unsigned char)v;
+  }
+  return (-1);
+}
+
+#ifdef RMD160_AVX2
+/*
+ * Sixteen bytes at a time: the nibbles index a table of the hex digits
+ * (pshufb), and sixteen characters at a time are range checked, turned to
+ * nibbles and paired (pmaddubsw) back into bytes.
+ * Digests are 20 or 40 bytes, so 128 bit registers carry the work
+ * and the odd tail goes through the scalar loops.
+ */
+RMD160_AVX2
+static void
+rmd160hexv(
+  const unsigned char *h
+ ,char *o
+){
+  const __m128i t = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+  const __m128i m = _mm_set1_epi8(0x0f);
+  __m128i b;
+  __m128i u;
+  __m128i l;
+  unsigned int i;
+
+  for (i = 0; i + 16 <= RMD160_SZ; i += 16) {
+    b = _mm_loadu_si128((const __m128i *)(h + i));
+    u = _mm_shuffle_epi8(t, _mm_and_si128(_mm_srli_epi16(b, 4), m));
+    l = _mm_shuffle_epi8(t, _mm_and_si128(b, m));
+    _mm_storeu_si128((__m128i *)(o + 2 * i), _mm_unpacklo_epi8(u, l));
+    _mm_storeu_si128((__m128i *)(o + 2 * i + 16), _mm_unpackhi_epi8(u, l));
+  }
+  rmd160hexs(h + i, o + 2 * i, RMD160_SZ - i);
+}
+
+RMD160_AVX2
+static int
+rmd160unhexv(
+  const char *s
+ ,unsigned char *h
+){
+  __m128i c;
+  __m128i w;
+  __m128i d;
+  __m128i a;
+  unsigned int k;
+  unsigned int i;
+  int r;
+
+  for (i = 0; i + 16 <= 2 * RMD160_SZ; i += 16) {
+    c = _mm_loadu_si128((const __m128i *)(s + i));
+    w = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    d = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    a = _mm_and_si128(_mm_cmpgt_epi8(w, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(w, _mm_set1_epi8('f' + 1)));
+    if ((k = (unsigned int)_mm_movemask_epi8(_mm_or_si128(d, a))) != 0xffff)
+      return ((int)(i + (unsigned int)__builtin_ctz(~k)));
+    c = _mm_blendv_epi8(_mm_sub_epi8(w, _mm_set1_epi8('a' - 10)), _mm_sub_epi8(c, _mm_set1_epi8('0')), d);
+    c = _mm_maddubs_epi16(c, _mm_set1_epi16(0x0110));
+    _mm_storel_epi64((__m128i *)(h + i / 2), _mm_packus_epi16(c, c));
+  }
+  if ((r = rmd160unhexs(s + i, h + i / 2, RMD160_SZ - i / 2)) >= 0)
+    r += (int)i;
+  return (r);
+}
+#endif /* RMD160_AVX2 */
+
+void
+rmd160hex(
+  const unsigned char *h
+ ,char *o
+){
+#ifdef RMD160_DISPATCH
+  if (!rmd160mix)
+    rmd160auto();
+#endif
+#ifdef RMD160_AVX2
+  if (RMD160_KL >= 2) {
+    rmd160hexv(h, o);
+    return;
+  }
+#endif
+  rmd160hexs(h, o, RMD160_SZ);
+}
+
+int
+rmd160unhex(
+  const char *s
+ ,unsigned char *h
+){
+#ifdef RMD160_DISPATCH
+  if (!rmd160mix)
+    rmd160auto();
+#endif
+#ifdef RMD160_AVX2
+  if (RMD160_KL >= 2)
+    return (rmd160unhexv(s, h));
+#endif
+  return (rmd160unhexs(s, h, RMD160_SZ));
+}
+
+void
+rmd160hexn(
+  unsigned int n
+ ,const unsigned char *h
+ ,char *o
+ ,unsigned int os
+){
+  for (; n; --n, h += RMD160_SZ, o += os)
+    rmd160hex(h, o);
+}
+
+unsigned int
+rmd160unhexn(
+  unsigned int n
+ ,const char *s
+ ,unsigned int ss
+ ,unsigned char *h
+){
+  unsigned int i;
+
+  for (i = 0; i < n; ++i, s += ss, h += RMD160_SZ)
+    if (rmd160unhex(s, h) >= 0)
+      break;
+  return (i);
+}
@@ -21,14 +21,71 @@
 #ifndef RMD160_H
 #define RMD160_H
 
+#include <stddef.h>
+
 #define RMD160_SZ 20
 typedef struct rmd160 rmd160_t;
 unsigned int rmd160tsize(void);
 void rmd160init(rmd160_t *);
 void rmd160update(rmd160_t *, const unsigned char *, unsigned int);
+void rmd160updatez(rmd160_t *, const unsigned char *, size_t); /* no 4 GiB limit on the length */
 void rmd160final(rmd160_t *, unsigned char *); /* RMD160_SZ */
+void rmd160copy(rmd160_t *, const rmd160_t *); /* a copy of a context mid stream, to hash on from */
+#define RMD160_STATESZ 100 /* exported state, the same bytes on any machine */
+void rmd160export(const rmd160_t *, unsigned char *s); /* RMD160_STATESZ, before rmd160final */
+int rmd160import(rmd160_t *, const unsigned char *s, unsigned long long *n); /* from rmd160export, n (if not 0) the bytes hashed so far; 0, else -1 if s is not one */
+void rmd160x8(const unsigned char *const *d, const unsigned int *l, unsigned char *h); /* 8 messages, 8 * RMD160_SZ */
+void rmd160x16(const unsigned char *const *d, const unsigned int *l, unsigned char *h); /* 16 messages, 16 * RMD160_SZ */
+void rmd160n(unsigned int n, const unsigned char *const *d, const unsigned int *l, unsigned char *h); /* n messages through the batch lanes, n * RMD160_SZ */
+void rmd160(const unsigned char *d, size_t l, unsigned char *h); /* one call, no context, RMD160_SZ */
+void rmd160fix20(const unsigned char *d, unsigned char *h); /* 20 byte message, RMD160_SZ */
+void rmd160fix32(const unsigned char *d, unsigned char *h); /* 32 byte message, RMD160_SZ */
+void rmd160fix33(const unsigned char *d, unsigned char *h); /* 33 byte message, RMD160_SZ */
+void rmd160fix65(const unsigned char *d, unsigned char *h); /* 65 byte message, RMD160_SZ */
+void rmd160fixn(unsigned int n, unsigned int l, const unsigned char *d, unsigned char *h); /* n messages of l bytes end to end, n * RMD160_SZ */
+typedef struct rmd160pfx rmd160pfx_t; /* a constant prefix, hashed once */
+unsigned int rmd160pfxtsize(void);
+void rmd160pfxinit(rmd160pfx_t *, const unsigned char *p, size_t pl);
+void rmd160pfxstart(const rmd160pfx_t *, rmd160_t *); /* a context that has hashed the prefix */
+void rmd160pfx(const rmd160pfx_t *, const unsigned char *d, size_t dl, unsigned char *h); /* RIPEMD-160(prefix | d), RMD160_SZ */
+void rmd160pfxn(const rmd160pfx_t *, unsigned int n, const unsigned char *const *d, const unsigned int *dl, unsigned char *h); /* n messages, n * RMD160_SZ, through the batch lanes when the prefix is whole blocks */
+typedef struct rmd160hkey rmd160hkey_t; /* HMAC key schedule: keyed inner and outer midstates */
+unsigned int rmd160hkeytsize(void);
+void rmd160hkeyinit(rmd160hkey_t *, const unsigned char *k, unsigned int kl);
+void rmd160hkeymac(const rmd160hkey_t *, const unsigned char *d, unsigned int dl, unsigned char *h); /* RMD160_SZ */
+void rmd160hkeymacz(const rmd160hkey_t *, const unsigned char *d, size_t dl, unsigned char *h); /* RMD160_SZ */
+void rmd160hkeymacn(const rmd160hkey_t *, unsigned int n, const unsigned char *const *d, const unsigned int *dl, unsigned char *h); /* n messages, n * RMD160_SZ */
+typedef struct rmd160hmac rmd160hmac_t; /* streaming HMAC */
+unsigned int rmd160hmactsize(void);
+void rmd160hmacinit(rmd160hmac_t *, const unsigned char *k, unsigned int kl);
+void rmd160hmacstart(rmd160hmac_t *, const rmd160hkey_t *); /* init from a key schedule */
+void rmd160hmacupdate(rmd160hmac_t *, const unsigned char *, unsigned int);
+void rmd160hmacupdatez(rmd160hmac_t *, const unsigned char *, size_t);
+void rmd160hmacfinal(rmd160hmac_t *, unsigned char *); /* RMD160_SZ, wipes the context */
 void rmd160hmac(const unsigned char *k, unsigned int kl, const unsigned char *d, unsigned int dl, unsigned char *h); /* RMD160_SZ */
-void rmd160hkdf(const unsigned char *k, unsigned int kl, const unsigned char *d, unsigned int dl, unsigned char *o, unsigned int ol); /* up to 255 * RMD160_SZ */
+void rmd160hmacz(const unsigned char *k, size_t kl, const unsigned char *d, size_t dl, unsigned char *h); /* RMD160_SZ */
+void rmd160hkeyhkdf(const rmd160hkey_t *, const unsigned char *d, unsigned int dl, unsigned char *o, unsigned int ol); /* HKDF-Expand from the key schedule of a PRK, up to 255 * RMD160_SZ */
+void rmd160hkeyhkdfz(const rmd160hkey_t *, const unsigned char *d, size_t dl, unsigned char *o, unsigned int ol); /* up to 255 * RMD160_SZ */
+void rmd160hkeyhkdfn(const rmd160hkey_t *, unsigned int n, const unsigned char *const *d, const unsigned int *dl, unsigned char *const *o, unsigned int ol); /* n infos, ol up to 255 * RMD160_SZ into each o[] */
+void rmd160hkdfextract(const unsigned char *s, unsigned int sl, const unsigned char *k, unsigned int kl, unsigned char *h); /* salt, IKM, PRK of RMD160_SZ */
+void rmd160hkdf(const unsigned char *k, unsigned int kl, const unsigned char *d, unsigned int dl, unsigned char *o, unsigned int ol); /* HKDF-Expand, PRK k, info d, up to 255 * RMD160_SZ */
+void rmd160hkdfz(const unsigned char *k, size_t kl, const unsigned char *d, size_t dl, unsigned char *o, unsigned int ol); /* up to 255 * RMD160_SZ */
+#define RMD160_CHUNK (1024U * 1024U) /* tree hash leaf size */
+typedef struct rmd160tree rmd160tree_t; /* streaming tree hash */
+unsigned int rmd160treetsize(void);
+void rmd160treeinit(rmd160tree_t *);
+void rmd160treeupdate(rmd160tree_t *, const unsigned char *, size_t);
+void rmd160treefinal(rmd160tree_t *, unsigned char *); /* RMD160_SZ */
+void rmd160tree(const unsigned char *d, size_t l, unsigned char *h); /* RMD160_SZ */
+void rmd160treeleafn(unsigned int n, const unsigned char *const *d, const unsigned int *l, unsigned char *h); /* n chunks of up to RMD160_CHUNK, n * RMD160_SZ */
+void rmd160treenode(const unsigned char *l, const unsigned char *r, unsigned char *h); /* RMD160_SZ each */
+void rmd160treenoden(unsigned int n, const unsigned char *p, unsigned char *h); /* n adjacent (left, right) pairs of RMD160_SZ, n * RMD160_SZ */
+void rmd160treeroot(unsigned char *a, size_t n, unsigned char *h); /* n leaves of RMD160_SZ (overwritten), RMD160_SZ */
 void rmd160hex(const unsigned char *, char *); /* RMD160_SZ, 2 * RMD160_SZ (not null-terminated) */
+int rmd160unhex(const char *, unsigned char *); /* 2 * RMD160_SZ hex digits in either case, RMD160_SZ; -1, else the offset of the first that is not one */
+void rmd160hexn(unsigned int n, const unsigned char *h, char *o, unsigned int os); /* n digests end to end, each 2 * RMD160_SZ characters at o + i * os */
+unsigned int rmd160unhexn(unsigned int n, const char *s, unsigned int ss, unsigned char *h); /* n hex digests at s + i * ss, n * RMD160_SZ; n, else the index of the first malformed */
+int rmd160kernel(const char *); /* "loop", "unroll", "avx2", "avx512" or 0 for fastest, -1 if not available */
+const char *rmd160kernelname(void); /* kernel in use */
 
 #endif /* RMD160_H */
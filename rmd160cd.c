@@ -0,0 +1,339 @@
+/*
+ * rmd160 - a small RIPEMD-160 / RIPEMD-320 implementation
+ * Copyright (C) 2018-2024 G. David Butler <gdb@dbSystems.com>
+ *
+ * This file is part of rmd160
+ *
+ * rmd160 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * rmd160 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "rmd160cd.h"
+
+/* gear table: 256 fixed random words (splitmix64 from "RMD160") */
+static const unsigned long long rmd160cdg[256] = {
+  0xbfbd42bf5fa2ec72ULL,0xb064950061561c1dULL,0x873d1a09d629e47dULL,0x7bd998874c6b0203ULL
+ ,0x52552fb3f906519bULL,0x01ac3e5571ed95b5ULL,0xcac355a7d96daa11ULL,0xcb3a3e38856cd5fdULL
+ ,0xb3d582c8707cde0fULL,0xac58a3ca4d00e9daULL,0xc02a73d8498a182eULL,0x4d1c277ba911c4efULL
+ ,0x52bbb9bc415e5c06ULL,0x93f4b874e2c45c34ULL,0x7e9a64dc7da1da97ULL,0x5b4f755cdd0e873aULL
+ ,0x452e32f52258b993ULL,0xe246b01fd08e7c07ULL,0x02d9708e6182a5d8ULL,0xf9d680383e0827abULL
+ ,0xeb65a16797f387a0ULL,0x2fd52e91ef31eab1ULL,0xdbd3a282d6d85c57ULL,0x7c8ef46545855cf3ULL
+ ,0x67193f83f10f4608ULL,0xd23fe4cbf2e9249aULL,0xb2c351631b77a449ULL,0x7b58d8545abf8dc1ULL
+ ,0x4d11b9b82855c725ULL,0x8a5b6fe9d2b4ff70ULL,0x4b6c32ed26ad3526ULL,0xd494a059a67b763dULL
+ ,0xae86f09b9507e725ULL,0x45da081e1afc7259ULL,0x0ab2123f85381757ULL,0xc2eef220129ad950ULL
+ ,0x6a3389a793f2f341ULL,0x39bb1107796d404bULL,0xc024c9434c434a89ULL,0xcd54e9b5333efb93ULL
+ ,0xcdfc39ab41d4994aULL,0x43bd321275299dfdULL,0x424c504242c0f220ULL,0xcb655b8fa6a9639dULL
+ ,0x243b8c404c1a1666ULL,0x4e198c5ee65f217bULL,0x4d9cc8e29c102f45ULL,0x2c2848d56e58adcfULL
+ ,0x06edda30facdd44dULL,0x2d545e1c1a755d7aULL,0x0da5a436b3b9e4b9ULL,0xbcc645ad3c04ac87ULL
+ ,0x04c546cc89c1c342ULL,0x648c12a0c7da282eULL,0xedaa7d0f15b9d7daULL,0x2977904cd4f4e1a2ULL
+ ,0x1df958aaa7bddd45ULL,0x4c90fe2f13b858eaULL,0x15323105de5928aeULL,0xa81fa784500e9081ULL
+ ,0x2389f4c837bf8fafULL,0xb08ae2f654058eb6ULL,0x448050c3c02cf16cULL,0xf230a3f70c024715ULL
+ ,0x522f1a52a453bde4ULL,0xcffa59b18f38bf3fULL,0x08a5721383f7538dULL,0xec17abc6dacc8fffULL
+ ,0x0c0aae7e882115d1ULL,0x8192c37bcfda9e05ULL,0x3ab5755db2a2bd7bULL,0x7e4acdeb8cd69b3fULL
+ ,0xc398576535c36700ULL,0x4edf010b71c12b99ULL,0x69c7e6a805b1a3beULL,0x4efa41237d178e91ULL
+ ,0xe6cdebc575665565ULL,0xe68bf7b8a100146dULL,0xaa23be4852029379ULL,0xbc1a6b892e841140ULL
+ ,0x763ef58592fc295fULL,0xbb1b22c9293ec6c6ULL,0xbf1d0435f5415489ULL,0x9df9a3110a4aeb9eULL
+ ,0x5129e8d272f90931ULL,0x6c3d9db063983016ULL,0xf72afc81fb1fcb2dULL,0x45038a363de47ed5ULL
+ ,0xf4a9107a74a45f8fULL,0x11aa80834a2bddaeULL,0x2dfb83c9c20cdc42ULL,0xc6952c8875eddf7fULL
+ ,0x1d3664d27733d418ULL,0x403af5b0c11bae3bULL,0x47c6fd2bd5fa55daULL,0x1bf893e03d428588ULL
+ ,0x3d084bd89101f6a9ULL,0xc96c6e1368157708ULL,0x75977643305662baULL,0x55d3280ef3e8971bULL
+ ,0x27d93aa60dd0d73aULL,0x4bafc36b416f54d5ULL,0x9b286abae260d63fULL,0xedaf7fc4ea6236dfULL
+ ,0xc2f1e25285fc7767ULL,0xfac4e075c21e7eb9ULL,0x06ce886971bed6baULL,0xe028f2185a2162ddULL
+ ,0x4c34250dec467f03ULL,0x21cbf5c6d0df2289ULL,0xf54cef5f5120f8a4ULL,0x9ccbee77867005c8ULL
+ ,0xaa2e27b250b9d883ULL,0x0d1bd8af839174e6ULL,0x79e59e989657c8fbULL,0x2cdafd3b989e2425ULL
+ ,0x9a17898c2a2a60a3ULL,0x45fd80835e454fc1ULL,0x544fdfa77e40ac55ULL,0x947449810a99a73cULL
+ ,0x1f6cf4c978f2c816ULL,0xc36f3b0e27215569ULL,0x495068fe4b3eae48ULL,0xdf9660e3f61639e6ULL
+ ,0x2e0d10e56ea541d1ULL,0x63a73c27ad86a0b4ULL,0x2116810656673e64ULL,0x2be0e737167deeffULL
+ ,0x7f31482d33bb5c3bULL,0x159f3e3105e9c23cULL,0xda5f994785eb485bULL,0xc255d56b6e34df7dULL
+ ,0xf536c6e5c135f413ULL,0x25928a964f3d1e65ULL,0x373308f4de66aa32ULL,0x3128b121a125b6bdULL
+ ,0x09796e58380e26e4ULL,0x2ac84361f4bf94d1ULL,0x837e517cb2439f22ULL,0x22f96824348dae20ULL
+ ,0x9d34fe0526c34e9bULL,0x052fe9da31fe9be5ULL,0xa5c503468a8af8caULL,0x7b82669e6fcfc18bULL
+ ,0x406ad94d7d1b31aaULL,0x66a4ffdece90d411ULL,0x291c5bf79e23ace2ULL,0x56b4e03ba177b915ULL
+ ,0xe135cac7dac2194aULL,0x65eee05b3e7c4122ULL,0xe8e6590c1043efabULL,0xa8ed9c8bb7a25261ULL
+ ,0xd863085f9da6f6e1ULL,0x61a1d398619a57abULL,0xf4eb9157d82933c1ULL,0x2161130dd95ce63bULL
+ ,0xb63deeeeab657462ULL,0x71b2e63c19c15684ULL,0x9a49bef4991a365bULL,0x9df859bb4d37d2efULL
+ ,0xcb122f9a2b98cafeULL,0xdbf30052d538ef80ULL,0x6bb7cf49b9425d26ULL,0xfee237ca696119f5ULL
+ ,0xa085a7e77f6f84c8ULL,0x2d43f9f52212b62aULL,0xe36fd521cf5745c6ULL,0x6994ca9bba3011f7ULL
+ ,0x98ea99f331acb842ULL,0xf812c4508b061a3eULL,0xe6d9f568bf4fd1b5ULL,0xf1b03ba663066514ULL
+ ,0x8d7e1062e74c2c2eULL,0xcbdca6d7de69ca1fULL,0x05c3077e41111467ULL,0xe9fbeb4d09ff737eULL
+ ,0x5d709ccfdc0b665eULL,0xe9ef1c153671b461ULL,0xe36d60c8c9920390ULL,0x28ecb34e9898cd17ULL
+ ,0xa54282429c03fb65ULL,0x1fedcdaa765b47d3ULL,0x0f25b1a6cdd70b4bULL,0x032b5fd9409e9d1eULL
+ ,0x1a960af1bace6184ULL,0x19c212c63f163c2dULL,0x268f40dcb314382aULL,0x3e7b4c7d5a030d51ULL
+ ,0x6c2a36a0edbdf89aULL,0xc026874526d3ea59ULL,0x52a354c115b8fecfULL,0x935ee23dc4966cb0ULL
+ ,0x0cfa65464a406275ULL,0xb829514a0f79f791ULL,0x4dda41a0f1066840ULL,0xaf6a58efe5d637daULL
+ ,0xeb25b6e85d0439b0ULL,0x04263bf93def9783ULL,0x40dc5eecbd49d067ULL,0x9d3f85e8f25fd62fULL
+ ,0x15e35482d660cd0cULL,0x521473d399445fb7ULL,0xac5a16228233ec07ULL,0x615b3261ed8bb09cULL
+ ,0xa96c3e08260ffbbbULL,0xaa91bfb184c70c39ULL,0xdc0c4fb2de941ef3ULL,0xfa4b7eeb51757ac1ULL
+ ,0x0ba68e9424f50941ULL,0x4043bd47b6b293f1ULL,0x51dbb469e7e7a1bdULL,0xd63173d582dcf1cbULL
+ ,0xf18af47da569aa21ULL,0x0afa090dbe83bf92ULL,0x2860cfdc7b589f44ULL,0xaefc32fb135d3ab6ULL
+ ,0xa304f271cfb9e868ULL,0xf2c6339ce99f0d7dULL,0xf2086d565083838bULL,0x49e200b98141d2faULL
+ ,0xfb8c4da155698e43ULL,0x5c4f9a616819715cULL,0x3d2c9a7083653a66ULL,0x0f09fe4b24fe0b60ULL
+ ,0x2f7a53a82d7f7ec1ULL,0x4e2774899b66eb80ULL,0x88bdce9ab6cf8cb5ULL,0xe28848ebd985807eULL
+ ,0x08a38c9d10bcb3feULL,0xf8d6ae37c23fb702ULL,0x0bee5452cfe2c824ULL,0xc52f074d70cf3dd9ULL
+ ,0x4ac851e5eebb9094ULL,0x4306171fd684e1c9ULL,0x89d2c420ee9a28d4ULL,0x0edcb2135b34bfbaULL
+ ,0x29d29cf97201db81ULL,0xf9d9dfea11ce30a1ULL,0xc3da9ce0a3703ab5ULL,0x21fe5f7555cc1b97ULL
+ ,0x5c96ec581453d645ULL,0xa57b7c65c4856b00ULL,0x9e40ff6ad3826a46ULL,0x28b76d015d287821ULL
+ ,0x2184af6b5282e7eaULL,0xc34a201436a04d48ULL,0x09a8050a7c7df09bULL,0x5cc778af0245aac6ULL
+ ,0x6100be967b7ac9a2ULL,0x3dd2d50168b418dfULL,0x54b45e6195adee2dULL,0x5f694b13f24b3d14ULL
+ ,0x5c6941d73a71dd50ULL,0x8718fb08f7db900dULL,0x6d86e59506eee9b0ULL,0x2905d97108ac5983ULL
+};
+
+#define RMD160CD_MS 0xfffe000000000000ULL /* 15 bits, before RMD160_CDAVG */
+#define RMD160CD_ML 0xffe0000000000000ULL /* 11 bits, after */
+#define RMD160CD_GROUP 64U /* chunks cut and then hashed while still in cache */
+
+unsigned int
+rmd160cdcut(
+  const unsigned char *d
+ ,size_t l
+){
+  unsigned long long g;
+  unsigned int n;
+  unsigned int m;
+  unsigned int i;
+
+  if (l <= RMD160_CDMIN)
+    return ((unsigned int)l);
+  n = l < RMD160_CDMAX ? (unsigned int)l : RMD160_CDMAX;
+  m = n < RMD160_CDAVG ? n : RMD160_CDAVG;
+  /* the hash covers the last 64 bytes, its top bits most of them */
+  for (g = 0, i = RMD160_CDMIN; i < m; ++i)
+    if (!((g = (g << 1) + rmd160cdg[d[i]]) & RMD160CD_MS))
+      return (i + 1);
+  for (; i < n; ++i)
+    if (!((g = (g << 1) + rmd160cdg[d[i]]) & RMD160CD_ML))
+      return (i + 1);
+  return (n);
+}
+
+void
+rmd160cdhashn(
+  unsigned int n
+ ,const unsigned char *const *d
+ ,const unsigned int *l
+ ,unsigned char *h
+){
+  const unsigned char *q[RMD160CD_GROUP];
+  unsigned int ql[RMD160CD_GROUP];
+  unsigned char qh[RMD160CD_GROUP * RMD160_SZ];
+  unsigned int x[RMD160CD_GROUP];
+  unsigned int g;
+  unsigned int i;
+  unsigned int j;
+  unsigned int t;
+
+  for (; n; n -= g, d += g, l += g, h += g * RMD160_SZ) {
+    g = n < RMD160CD_GROUP ? n : RMD160CD_GROUP;
+    /* a batch runs as long as its longest lane, so batch similar lengths */
+    for (i = 0; i < g; ++i) {
+      for (t = i, j = i; j && l[x[j - 1]] > l[t]; --j)
+        x[j] = x[j - 1];
+      x[j] = t;
+    }
+    for (i = 0; i < g; ++i) {
+      q[i] = d[x[i]];
+      ql[i] = l[x[i]];
+    }
+    rmd160n(g, q, ql, qh);
+    for (i = 0; i < g; ++i)
+      for (j = 0; j < RMD160_SZ; ++j)
+        h[x[i] * RMD160_SZ + j] = qh[i * RMD160_SZ + j];
+  }
+}
+
+unsigned int
+rmd160cd(
+  const unsigned char *d
+ ,size_t l
+ ,int e
+ ,unsigned int n
+ ,unsigned int *c
+ ,unsigned char *h
+){
+  const unsigned char *q[RMD160CD_GROUP];
+  unsigned int k;
+  unsigned int g;
+  unsigned int t;
+  int z;
+
+  for (z = 0, k = 0; !z && k < n && l; k += g, h += g * RMD160_SZ) {
+    for (g = 0; g < RMD160CD_GROUP && k + g < n && l; ++g, d += t, l -= t) {
+      t = rmd160cdcut(d, l);
+      if (!e && t == l && t < RMD160_CDMAX) {
+        z = 1; /* the cut may be further on */
+        break;
+      }
+      q[g] = d;
+      c[k + g] = t;
+    }
+    rmd160cdhashn(g, q, c + k, h);
+  }
+  return (k);
+}
+
+struct rmd160cds {
+  size_t s;             /* 0 empty, 1 being filled, else value + 2 */
+  unsigned char h[RMD160_SZ];
+};
+
+struct rmd160cdix {
+  size_t n;             /* most digests */
+  size_t m;             /* slots - 1 */
+  size_t c;             /* digests */
+  struct rmd160cds s[];
+};
+
+#if defined(__GNUC__)
+#define RMD160CD_LOAD(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define RMD160CD_STORE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define RMD160CD_CAS(p, o, v) __atomic_compare_exchange_n(p, o, v, 0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)
+#define RMD160CD_ADD(p, v) __atomic_add_fetch(p, v, __ATOMIC_RELAXED)
+#define RMD160CD_SUB(p, v) __atomic_sub_fetch(p, v, __ATOMIC_RELAXED)
+#else /* one thread at a time */
+#define RMD160CD_LOAD(p) (*(p))
+#define RMD160CD_STORE(p, v) (*(p) = (v))
+#define RMD160CD_CAS(p, o, v) (*(p) == *(o) ? (*(p) = (v), 1) : (*(o) = *(p), 0))
+#define RMD160CD_ADD(p, v) (*(p) += (v))
+#define RMD160CD_SUB(p, v) (*(p) -= (v))
+#endif
+
+/* slots, a power of two with a third or more to spare */
+static size_t
+rmd160cdixslots(
+  size_t n
+){
+  size_t s;
+
+  for (s = 2; s < n + n / 2 + 1; s *= 2);
+  return (s);
+}
+
+size_t
+rmd160cdixtsize(
+  size_t n
+){
+  return (sizeof (rmd160cdix_t) + rmd160cdixslots(n) * sizeof (struct rmd160cds));
+}
+
+rmd160cdix_t *
+rmd160cdixinit(
+  void *v
+ ,size_t n
+){
+  rmd160cdix_t *t;
+  size_t i;
+
+  t = v;
+  t->n = n;
+  t->m = rmd160cdixslots(n) - 1;
+  t->c = 0;
+  for (i = 0; i <= t->m; ++i)
+    t->s[i].s = 0;
+  return (t);
+}
+
+size_t
+rmd160cdixcount(
+  const rmd160cdix_t *t
+){
+  return (RMD160CD_LOAD(&t->c));
+}
+
+/* digests are uniform, their leading bytes make the slot */
+static size_t
+rmd160cdixkey(
+  const unsigned char *h
+){
+  size_t k;
+  unsigned int i;
+
+  for (k = 0, i = 0; i < sizeof (k); ++i)
+    k = k << 8 | h[i];
+  return (k);
+}
+
+static int
+rmd160cdixeq(
+  const unsigned char *a
+ ,const unsigned char *b
+){
+  unsigned int i;
+
+  for (i = 0; i < RMD160_SZ; ++i)
+    if (a[i] != b[i])
+      return (0);
+  return (1);
+}
+
+int
+rmd160cdixput(
+  rmd160cdix_t *t
+ ,const unsigned char *h
+ ,size_t v
+ ,size_t *o
+){
+  struct rmd160cds *s;
+  size_t i;
+  size_t w;
+  unsigned int j;
+
+  for (i = rmd160cdixkey(h) & t->m;; i = (i + 1) & t->m) {
+    s = t->s + i;
+    for (;;) {
+      if (!(w = RMD160CD_LOAD(&s->s))) {
+        if (RMD160CD_ADD(&t->c, 1) > t->n) {
+          RMD160CD_SUB(&t->c, 1);
+          return (-1);
+        }
+        if (RMD160CD_CAS(&s->s, &w, 1)) {
+          for (j = 0; j < RMD160_SZ; ++j)
+            s->h[j] = h[j];
+          RMD160CD_STORE(&s->s, v + 2);
+          return (1);
+        }
+        RMD160CD_SUB(&t->c, 1); /* another thread took the slot */
+        continue;
+      }
+      if (w == 1) /* another thread is filling the slot */
+        continue;
+      if (!rmd160cdixeq(s->h, h))
+        break;
+      if (o)
+        *o = w - 2;
+      return (0);
+    }
+  }
+}
+
+int
+rmd160cdixget(
+  const rmd160cdix_t *t
+ ,const unsigned char *h
+ ,size_t *o
+){
+  const struct rmd160cds *s;
+  size_t i;
+  size_t w;
+
+  for (i = rmd160cdixkey(h) & t->m;; i = (i + 1) & t->m) {
+    s = t->s + i;
+    while ((w = RMD160CD_LOAD(&s->s)) == 1);
+    if (!w)
+      return (0);
+    if (rmd160cdixeq(s->h, h)) {
+      if (o)
+        *o = w - 2;
+      return (1);
+    }
+  }
+}
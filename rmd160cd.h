@@ -0,0 +1,50 @@
+/*
+ * rmd160 - a small RIPEMD-160 / RIPEMD-320 implementation
+ * Copyright (C) 2018-2024 G. David Butler <gdb@dbSystems.com>
+ *
+ * This file is part of rmd160
+ *
+ * rmd160 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * rmd160 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RMD160CD_H
+#define RMD160CD_H
+
+#include "rmd160.h"
+
+/*
+ * Content defined chunking for deduplication with RIPEMD-160 addresses.
+ * Cut points come from a gear hash over the last 64 bytes, with a stricter
+ * test before RMD160_CDAVG bytes and a looser one after (normalized chunking)
+ * to keep sizes near the average, so an insertion moves only nearby cuts.
+ */
+#define RMD160_CDMIN (2U * 1024U)  /* smallest chunk but the last */
+#define RMD160_CDAVG (8U * 1024U)  /* typical chunk */
+#define RMD160_CDMAX (64U * 1024U) /* largest chunk */
+unsigned int rmd160cdcut(const unsigned char *d, size_t l); /* bytes of the chunk at d given l bytes; l itself when l < RMD160_CDMAX without a cut */
+unsigned int rmd160cd(const unsigned char *d, size_t l, int e, unsigned int n, unsigned int *c, unsigned char *h); /* cut up to n chunks from d, their lengths in c and digests in h (n * RMD160_SZ), returns how many; unless e (the input ends at l) an uncut tail is left for more input */
+void rmd160cdhashn(unsigned int n, const unsigned char *const *d, const unsigned int *l, unsigned char *h); /* n chunks, n * RMD160_SZ, similar lengths sharing the batch lanes */
+
+/*
+ * Digest to chunk table for up to n distinct digests, open addressed,
+ * fixed in size and safe to insert into and search from several threads.
+ */
+typedef struct rmd160cdix rmd160cdix_t;
+size_t rmd160cdixtsize(size_t n);
+rmd160cdix_t *rmd160cdixinit(void *t, size_t n); /* rmd160cdixtsize(n) bytes */
+size_t rmd160cdixcount(const rmd160cdix_t *);
+int rmd160cdixput(rmd160cdix_t *, const unsigned char *h, size_t v, size_t *o); /* 1 if h was new and now has value v, 0 if present with value *o, -1 if full */
+int rmd160cdixget(const rmd160cdix_t *, const unsigned char *h, size_t *o); /* 1 if present with value *o */
+
+#endif /* RMD160CD_H */
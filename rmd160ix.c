@@ -0,0 +1,316 @@
+/*
+ * rmd160 - a small RIPEMD-160 / RIPEMD-320 implementation
+ * Copyright (C) 2018-2024 G. David Butler <gdb@dbSystems.com>
+ *
+ * This file is part of rmd160
+ *
+ * rmd160 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * rmd160 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "rmd160ix.h"
+
+struct rmd160ix {
+  unsigned char m[8];   /* "RMD160IX" */
+  unsigned char n[8];   /* digests, little endian */
+  unsigned char b[8];   /* fanout bits, then zero */
+  unsigned char f[][8]; /* 2^bits + 1 counts, little endian, then the digests */
+};
+
+static const unsigned char rmd160ixm[8] = { 'R', 'M', 'D', '1', '6', '0', 'I', 'X' };
+
+#define RMD160IX_BITS 24 /* largest fanout, a 128 MiB table */
+
+static size_t
+rmd160ixget(
+  const unsigned char *p
+){
+  size_t n;
+  unsigned int i;
+
+  for (n = 0, i = 8; i; --i)
+    n = n << 8 | p[i - 1];
+  return (n);
+}
+
+static void
+rmd160ixput(
+  unsigned char *p
+ ,size_t n
+){
+  unsigned int i;
+
+  for (i = 0; i < 8; ++i, n = n >> 8)
+    p[i] = (unsigned char)n;
+}
+
+/* leading 64 bits of a digest, ordered as the digests are */
+static unsigned long long
+rmd160ixkey(
+  const unsigned char *h
+){
+  unsigned long long k;
+  unsigned int i;
+
+  for (k = 0, i = 0; i < 8; ++i)
+    k = k << 8 | h[i];
+  return (k);
+}
+
+static const unsigned char *
+rmd160ixdigests(
+  const rmd160ix_t *t
+){
+  return (t->f[((size_t)1 << t->b[0]) + 1]);
+}
+
+size_t
+rmd160ixsize(
+  size_t n
+ ,unsigned int b
+){
+  if (b > RMD160IX_BITS)
+    return (0);
+  return (sizeof (rmd160ix_t) + (((size_t)1 << b) + 1) * 8 + n * RMD160_SZ);
+}
+
+static int
+rmd160ixcmp(
+  const void *a
+ ,const void *b
+){
+  return (memcmp(a, b, RMD160_SZ));
+}
+
+size_t
+rmd160ixbuild(
+  void *v
+ ,unsigned char *d
+ ,size_t n
+ ,unsigned int b
+){
+  rmd160ix_t *t;
+  unsigned char *o;
+  size_t i;
+  size_t m;
+  size_t p;
+
+  if (b > RMD160IX_BITS)
+    return (0);
+  if (n > 1)
+    qsort(d, n, RMD160_SZ, rmd160ixcmp);
+  for (m = i = 0; i < n; ++i)
+    if (!m || memcmp(d + (m - 1) * RMD160_SZ, d + i * RMD160_SZ, RMD160_SZ)) {
+      if (m != i)
+        memcpy(d + m * RMD160_SZ, d + i * RMD160_SZ, RMD160_SZ);
+      ++m;
+    }
+  t = v;
+  memcpy(t->m, rmd160ixm, sizeof (t->m));
+  rmd160ixput(t->n, m);
+  rmd160ixput(t->b, b);
+  o = t->f[((size_t)1 << b) + 1];
+  if (o != d && m)
+    memmove(o, d, m * RMD160_SZ);
+  /* counts of digests below each prefix */
+  for (i = p = 0; p <= (size_t)1 << b; ++p) {
+    for (; i < m && (b ? rmd160ixkey(o + i * RMD160_SZ) >> (64 - b) : 0) < p; ++i);
+    rmd160ixput(t->f[p], i);
+  }
+  return (rmd160ixsize(m, b));
+}
+
+size_t
+rmd160ixcount(
+  const rmd160ix_t *t
+){
+  return (rmd160ixget(t->n));
+}
+
+rmd160ix_t *
+rmd160ixopen(
+  void *v
+ ,size_t z
+){
+  rmd160ix_t *t;
+  size_t n;
+  size_t p;
+  size_t c;
+  unsigned int i;
+
+  t = v;
+  if (z < sizeof (*t))
+    return (0);
+  for (i = 0; i < sizeof (t->m); ++i)
+    if (t->m[i] != rmd160ixm[i])
+      return (0);
+  for (i = sizeof (size_t); i < sizeof (t->n); ++i)
+    if (t->n[i]) /* more digests than this machine can address */
+      return (0);
+  for (i = 1; i < sizeof (t->b); ++i)
+    if (t->b[i])
+      return (0);
+  n = rmd160ixcount(t);
+  if (t->b[0] > RMD160IX_BITS
+   || n > (z - sizeof (*t)) / RMD160_SZ
+   || z < rmd160ixsize(n, t->b[0]))
+    return (0);
+  /* a table that stays in bounds keeps every search in bounds */
+  for (c = p = 0; p <= (size_t)1 << t->b[0]; ++p) {
+    if (rmd160ixget(t->f[p]) < c)
+      return (0);
+    c = rmd160ixget(t->f[p]);
+  }
+  if (c != n)
+    return (0);
+  return (t);
+}
+
+/* digests of h's bucket */
+static void
+rmd160ixbucket(
+  const rmd160ix_t *t
+ ,const unsigned char *h
+ ,size_t *l
+ ,size_t *u
+){
+  size_t p;
+
+  p = t->b[0] ? (size_t)(rmd160ixkey(h) >> (64 - t->b[0])) : 0;
+  *l = rmd160ixget(t->f[p]);
+  *u = rmd160ixget(t->f[p + 1]);
+}
+
+/* where h would be in [l, u) if the keys are spread evenly */
+static size_t
+rmd160ixguess(
+  const unsigned char *d
+ ,const unsigned char *h
+ ,size_t l
+ ,size_t u
+){
+  unsigned long long k;
+  unsigned long long a;
+  unsigned long long z;
+
+  k = rmd160ixkey(h);
+  a = rmd160ixkey(d + l * RMD160_SZ);
+  z = rmd160ixkey(d + (u - 1) * RMD160_SZ);
+  if (k <= a)
+    return (l);
+  if (k >= z)
+    return (u - 1);
+  return (l + (size_t)((double)(k - a) / ((double)(z - a) + 1.0) * (double)(u - l)));
+}
+
+/* interpolate a few times, then halve what is left */
+static int
+rmd160ixsearch(
+  const unsigned char *d
+ ,const unsigned char *h
+ ,size_t l
+ ,size_t u
+ ,size_t g
+){
+  size_t m;
+  unsigned int s;
+  int c;
+
+  for (s = 0; l < u; ++s) {
+    if (!s)
+      m = g;
+    else if (s < 3 && u - l > 8)
+      m = rmd160ixguess(d, h, l, u);
+    else
+      m = l + (u - l) / 2;
+    if (!(c = memcmp(h, d + m * RMD160_SZ, RMD160_SZ)))
+      return (1);
+    if (c < 0)
+      u = m;
+    else
+      l = m + 1;
+  }
+  return (0);
+}
+
+int
+rmd160ixfind(
+  const rmd160ix_t *t
+ ,const unsigned char *h
+){
+  const unsigned char *d;
+  size_t l;
+  size_t u;
+
+  rmd160ixbucket(t, h, &l, &u);
+  if (l >= u)
+    return (0);
+  d = rmd160ixdigests(t);
+  return (rmd160ixsearch(d, h, l, u, rmd160ixguess(d, h, l, u)));
+}
+
+#define RMD160IX_AHEAD 16 /* queries with loads in flight */
+
+#if defined(__GNUC__)
+#define RMD160IX_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define RMD160IX_PREFETCH(p) (void)(p)
+#endif
+
+/*
+ * A lookup is a few dependent misses (table, then digests) on a large index.
+ * Each group of queries first touches every table entry, then every first guess,
+ * so the misses of the group overlap instead of following one another.
+ */
+size_t
+rmd160ixfindn(
+  const rmd160ix_t *t
+ ,size_t n
+ ,const unsigned char *h
+ ,unsigned char *r
+){
+  const unsigned char *d;
+  size_t l[RMD160IX_AHEAD];
+  size_t u[RMD160IX_AHEAD];
+  size_t g[RMD160IX_AHEAD];
+  size_t c;
+  size_t p;
+  unsigned int a;
+  unsigned int i;
+
+  d = rmd160ixdigests(t);
+  for (c = 0; n; n -= a, h += a * RMD160_SZ, r += a) {
+    a = n < RMD160IX_AHEAD ? (unsigned int)n : RMD160IX_AHEAD;
+    for (i = 0; i < a; ++i) {
+      p = t->b[0] ? (size_t)(rmd160ixkey(h + i * RMD160_SZ) >> (64 - t->b[0])) : 0;
+      RMD160IX_PREFETCH(t->f[p]);
+    }
+    for (i = 0; i < a; ++i) {
+      rmd160ixbucket(t, h + i * RMD160_SZ, l + i, u + i);
+      if (l[i] < u[i]) {
+        RMD160IX_PREFETCH(d + l[i] * RMD160_SZ);
+        RMD160IX_PREFETCH(d + (u[i] - 1) * RMD160_SZ);
+      }
+    }
+    for (i = 0; i < a; ++i)
+      if (l[i] < u[i]) {
+        g[i] = rmd160ixguess(d, h + i * RMD160_SZ, l[i], u[i]);
+        RMD160IX_PREFETCH(d + g[i] * RMD160_SZ);
+      }
+    for (i = 0; i < a; ++i)
+      c += r[i] = l[i] < u[i] && rmd160ixsearch(d, h + i * RMD160_SZ, l[i], u[i], g[i]);
+  }
+  return (c);
+}
@@ -0,0 +1,42 @@
+/*
+ * rmd160 - a small RIPEMD-160 / RIPEMD-320 implementation
+ * Copyright (C) 2018-2024 G. David Butler <gdb@dbSystems.com>
+ *
+ * This file is part of rmd160
+ *
+ * rmd160 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * rmd160 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RMD160IX_H
+#define RMD160IX_H
+
+#include "rmd160.h"
+
+/*
+ * Index of distinct RIPEMD-160 digests for membership tests: a header,
+ * a fanout table of 2^bits + 1 little endian counts (digests whose leading
+ * bits are below each value) and the raw digests in ascending order.
+ * Laid out the same in memory and in a file, so a mapped file is searched
+ * with no parsing; bits around log2(n) - 4 keep a few digests per bucket.
+ */
+typedef struct rmd160ix rmd160ix_t;
+size_t rmd160ixsize(size_t n, unsigned int bits); /* bytes for up to n digests, bits up to 24 */
+size_t rmd160ixbuild(void *t, unsigned char *d, size_t n, unsigned int bits); /* sort (in place) the n digests d, drop repeats and lay out the index in t, returns its bytes */
+/* d may already be where the index keeps them, rmd160ixsize(0, bits) bytes into t, saving a copy */
+rmd160ix_t *rmd160ixopen(void *t, size_t z); /* z bytes built by rmd160ixbuild (e.g. a mapped file), 0 if not */
+size_t rmd160ixcount(const rmd160ix_t *);
+int rmd160ixfind(const rmd160ix_t *, const unsigned char *h); /* 1 if digest h is in the index */
+size_t rmd160ixfindn(const rmd160ix_t *, size_t n, const unsigned char *h, unsigned char *r); /* n digests end to end, r[i] 1 if found, returns how many were */
+
+#endif /* RMD160IX_H */
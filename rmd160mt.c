@@ -0,0 +1,268 @@
+/*
+ * rmd160 - a small RIPEMD-160 / RIPEMD-320 implementation
+ * Copyright (C) 2018-2024 G. David Butler <gdb@dbSystems.com>
+ *
+ * This file is part of rmd160
+ *
+ * rmd160 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * rmd160 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "rmd160mt.h"
+
+struct rmd160mt {
+  unsigned char m[8];   /* "RMD160MT" */
+  unsigned char n[8];   /* leaves, little endian */
+  unsigned char h[][RMD160_SZ]; /* every level, leaves first, root last */
+};
+
+static const unsigned char rmd160mtm[8] = { 'R', 'M', 'D', '1', '6', '0', 'M', 'T' };
+
+/* nodes in the levels of a tree of n leaves */
+static size_t
+rmd160mtnodes(
+  size_t n
+){
+  size_t c;
+
+  for (c = n; n > 1; n = (n + 1) / 2)
+    c += (n + 1) / 2;
+  return (c);
+}
+
+size_t
+rmd160mtsize(
+  size_t n
+){
+  return (sizeof (rmd160mt_t) + rmd160mtnodes(n) * RMD160_SZ);
+}
+
+size_t
+rmd160mtleaves(
+  const rmd160mt_t *t
+){
+  size_t n;
+  unsigned int i;
+
+  for (n = 0, i = 8; i; --i)
+    n = n << 8 | t->n[i - 1];
+  return (n);
+}
+
+rmd160mt_t *
+rmd160mtopen(
+  void *v
+ ,size_t z
+){
+  rmd160mt_t *t;
+  size_t n;
+  unsigned int i;
+
+  t = v;
+  if (z < sizeof (*t))
+    return (0);
+  for (i = 0; i < sizeof (t->m); ++i)
+    if (t->m[i] != rmd160mtm[i])
+      return (0);
+  for (i = sizeof (size_t); i < sizeof (t->n); ++i)
+    if (t->n[i]) /* more leaves than this machine can address */
+      return (0);
+  /* the leaves alone must fit, so rmd160mtsize (under 2 z) cannot wrap */
+  if (!(n = rmd160mtleaves(t))
+   || n > (z - sizeof (*t)) / RMD160_SZ
+   || z < rmd160mtsize(n))
+    return (0);
+  return (t);
+}
+
+rmd160mt_t *
+rmd160mtinit(
+  void *v
+ ,size_t n
+){
+  rmd160mt_t *t;
+  const unsigned char *d;
+  unsigned int l;
+  size_t i;
+  unsigned int j;
+
+  if (!n)
+    return (0);
+  t = v;
+  for (j = 0; j < sizeof (t->m); ++j)
+    t->m[j] = rmd160mtm[j];
+  for (i = n, j = 0; j < sizeof (t->n); ++j, i = i >> 8)
+    t->n[j] = (unsigned char)i;
+  d = t->m;
+  l = 0;
+  rmd160treeleafn(1, &d, &l, t->h[0]);
+  for (i = 1; i < n; ++i)
+    for (j = 0; j < RMD160_SZ; ++j)
+      t->h[i][j] = t->h[0][j];
+  rmd160mtcommit(t);
+  return (t);
+}
+
+/* recompute the parents of leaf i up to the root */
+static void
+rmd160mtpath(
+  rmd160mt_t *t
+ ,size_t i
+){
+  size_t n;
+  size_t o;
+  unsigned int j;
+
+  for (n = rmd160mtleaves(t), o = 0; n > 1; o += n, n = (n + 1) / 2, i /= 2)
+    if ((i ^ 1) < n)
+      rmd160treenoden(1, t->h[o + (i & ~(size_t)1)], t->h[o + n + i / 2]);
+    else /* the odd node out moves up */
+      for (j = 0; j < RMD160_SZ; ++j)
+        t->h[o + n + i / 2][j] = t->h[o + i][j];
+}
+
+void
+rmd160mtsetleaf(
+  rmd160mt_t *t
+ ,size_t i
+ ,const unsigned char *h
+){
+  unsigned int j;
+
+  for (j = 0; j < RMD160_SZ; ++j)
+    t->h[i][j] = h[j];
+  rmd160mtpath(t, i);
+}
+
+void
+rmd160mtset(
+  rmd160mt_t *t
+ ,size_t i
+ ,const unsigned char *d
+ ,unsigned int l
+){
+  rmd160treeleafn(1, &d, &l, t->h[i]);
+  rmd160mtpath(t, i);
+}
+
+/* leaves of disjoint ranges may be loaded from several threads at once */
+void
+rmd160mtload(
+  rmd160mt_t *t
+ ,size_t i
+ ,unsigned int n
+ ,const unsigned char *const *d
+ ,const unsigned int *l
+){
+  rmd160treeleafn(n, d, l, t->h[i]);
+}
+
+void
+rmd160mtcommit(
+  rmd160mt_t *t
+){
+  size_t n;
+  size_t o;
+  size_t i;
+  unsigned int g;
+  unsigned int j;
+
+  for (n = rmd160mtleaves(t), o = 0; n > 1; o += n, n = (n + 1) / 2) {
+    for (i = 0; i < n / 2; i += g) {
+      g = n / 2 - i < 1024 ? (unsigned int)(n / 2 - i) : 1024;
+      rmd160treenoden(g, t->h[o + 2 * i], t->h[o + n + i]);
+    }
+    if (n & 1)
+      for (j = 0; j < RMD160_SZ; ++j)
+        t->h[o + n + n / 2][j] = t->h[o + n - 1][j];
+  }
+}
+
+void
+rmd160mtleaf(
+  const rmd160mt_t *t
+ ,size_t i
+ ,unsigned char *h
+){
+  unsigned int j;
+
+  for (j = 0; j < RMD160_SZ; ++j)
+    h[j] = t->h[i][j];
+}
+
+void
+rmd160mtroot(
+  const rmd160mt_t *t
+ ,unsigned char *h
+){
+  size_t n;
+  unsigned int j;
+
+  n = rmd160mtnodes(rmd160mtleaves(t)) - 1;
+  for (j = 0; j < RMD160_SZ; ++j)
+    h[j] = t->h[n][j];
+}
+
+unsigned int
+rmd160mtproof(
+  const rmd160mt_t *t
+ ,size_t i
+ ,unsigned char *p
+){
+  size_t n;
+  size_t o;
+  unsigned int c;
+  unsigned int j;
+
+  for (c = 0, n = rmd160mtleaves(t), o = 0; n > 1; o += n, n = (n + 1) / 2, i /= 2)
+    if ((i ^ 1) < n) {
+      for (j = 0; j < RMD160_SZ; ++j)
+        *p++ = t->h[o + (i ^ 1)][j];
+      ++c;
+    }
+  return (c);
+}
+
+int
+rmd160mtverify(
+  size_t n
+ ,size_t i
+ ,const unsigned char *h
+ ,const unsigned char *p
+ ,unsigned int c
+ ,const unsigned char *r
+){
+  unsigned char x[RMD160_SZ];
+  unsigned int j;
+
+  if (i >= n)
+    return (-1);
+  for (j = 0; j < RMD160_SZ; ++j)
+    x[j] = h[j];
+  for (; n > 1; n = (n + 1) / 2, i /= 2)
+    if ((i ^ 1) < n) {
+      if (!c--)
+        return (-1);
+      if (i & 1)
+        rmd160treenode(p, x, x);
+      else
+        rmd160treenode(x, p, x);
+      p += RMD160_SZ;
+    }
+  if (c)
+    return (-1);
+  for (j = 0; j < RMD160_SZ; ++j)
+    if (x[j] != r[j])
+      return (-1);
+  return (0);
+}
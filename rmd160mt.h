@@ -0,0 +1,48 @@
+/*
+ * rmd160 - a small RIPEMD-160 / RIPEMD-320 implementation
+ * Copyright (C) 2018-2024 G. David Butler <gdb@dbSystems.com>
+ *
+ * This file is part of rmd160
+ *
+ * rmd160 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * rmd160 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RMD160MT_H
+#define RMD160MT_H
+
+#include "rmd160.h"
+
+/*
+ * Merkle tree over n leaves with the rmd160tree construction:
+ * leaf = RIPEMD-160(L | data), node = RIPEMD-160(N | left | right),
+ * an odd node at the end of a level moving up unpaired.
+ * The tree is one flat region (header, then each level leaves first, root
+ * last) that is the same byte for byte in memory and in a file,
+ * so a mapped file is a tree with nothing to load.
+ */
+typedef struct rmd160mt rmd160mt_t;
+size_t rmd160mtsize(size_t n); /* bytes for n > 0 leaves */
+rmd160mt_t *rmd160mtinit(void *t, size_t n); /* format rmd160mtsize(n) bytes, every leaf empty data */
+rmd160mt_t *rmd160mtopen(void *t, size_t z); /* z bytes formatted by rmd160mtinit (e.g. a mapped file), 0 if not */
+size_t rmd160mtleaves(const rmd160mt_t *);
+void rmd160mtset(rmd160mt_t *, size_t i, const unsigned char *d, unsigned int l); /* leaf i hashes data d, the path to the root updated */
+void rmd160mtsetleaf(rmd160mt_t *, size_t i, const unsigned char *h); /* leaf i is the digest h, the path to the root updated */
+void rmd160mtload(rmd160mt_t *, size_t i, unsigned int n, const unsigned char *const *d, const unsigned int *l); /* leaves i to i + n - 1 through the batch lanes, parents left for rmd160mtcommit */
+void rmd160mtcommit(rmd160mt_t *); /* rehash every parent, level by level through the batch lanes */
+void rmd160mtleaf(const rmd160mt_t *, size_t i, unsigned char *h); /* digest of leaf i, RMD160_SZ */
+void rmd160mtroot(const rmd160mt_t *, unsigned char *h); /* RMD160_SZ */
+unsigned int rmd160mtproof(const rmd160mt_t *, size_t i, unsigned char *p); /* siblings of leaf i, leaf first, returns how many, up to 64 * RMD160_SZ */
+int rmd160mtverify(size_t n, size_t i, const unsigned char *h, const unsigned char *p, unsigned int c, const unsigned char *r); /* leaf digest h is leaf i of n under root r given c siblings p, 0 if so */
+
+#endif /* RMD160MT_H */
@@ -19,6 +19,41 @@
  */
 
 #include "rmd320.h"
+#ifdef RMD320_DISPATCH
+#include <stdlib.h>
+#endif
+
+/*
+ * RMD320_DISPATCH compiles every kernel into one object and picks among
+ * them at run time, so the SIMD kernels carry a target attribute rather
+ * than relying on -mavx2 / -mavx512f for the whole file.
+ */
+#if defined(RMD320_DISPATCH) && (defined(__x86_64__) || defined(__i386__))
+#define RMD320_AVX2 __attribute__((target("avx2")))
+#define RMD320_AVX512F __attribute__((target("avx512f")))
+#define RMD320_AVX512VL __attribute__((target("avx512f,avx512vl")))
+#else
+#ifdef __AVX2__
+#define RMD320_AVX2
+#endif
+#ifdef __AVX512F__
+#define RMD320_AVX512F
+#ifdef __AVX512VL__
+#define RMD320_AVX512VL
+#endif
+#endif
+#endif
+#if defined(RMD320_AVX2) || defined(RMD320_AVX512F)
+#include <immintrin.h>
+#endif
+
+/*
+ * Kernel levels are supersets (see rmd320mix below), so without
+ * RMD320_DISPATCH an AVX-512 build also runs the unrolled kernel.
+ */
+#if !defined(RMD320_DISPATCH) && !defined(RMD320_UNROLL) && defined(RMD320_AVX512F)
+#define RMD320_UNROLL
+#endif
 
 typedef unsigned int rmd320_bt; /* unsigned 32 bits */
 typedef int rmd320_bt_size_check[sizeof (rmd320_bt) == 4 ? 1 : -1];
@@ -37,28 +72,306 @@ rmd320tsize(
   return (sizeof (rmd320_t));
 }
 
-void
-rmd320init(
-  rmd320_t *v
+/*
+ * Unrolled step sequences: all 160 steps with the message word index,
+ * rotate amount and added constant of each step an immediate.
+ * The l (left) and r (right) lines rotate their a..e roles through the
+ * macro arguments rather than through (j + phase) % 5 arithmetic.
+ * A kernel defines RMD320_ADD, RMD320_ROL, RMD320_K and RMD320_F1..F5
+ * for its word type before expanding them.
+ */
+#define RMD320_S(a, b, c, d, e, f, k, x, s) \
+  a = RMD320_ADD(a, RMD320_ADD(f(b, c, d), RMD320_ADD(w[x], RMD320_K(k)))); \
+  a = RMD320_ADD(RMD320_ROL(a, s), e); \
+  c = RMD320_ROL(c, 10)
+
+#define RMD320_L1(a, b, c, d, e) \
+  RMD320_S(a, b, c, d, e, RMD320_F1, 0x00000000U,  0, 11); \
+  RMD320_S(e, a, b, c, d, RMD320_F1, 0x00000000U,  1, 14); \
+  RMD320_S(d, e, a, b, c, RMD320_F1, 0x00000000U,  2, 15); \
+  RMD320_S(c, d, e, a, b, RMD320_F1, 0x00000000U,  3, 12); \
+  RMD320_S(b, c, d, e, a, RMD320_F1, 0x00000000U,  4,  5); \
+  RMD320_S(a, b, c, d, e, RMD320_F1, 0x00000000U,  5,  8); \
+  RMD320_S(e, a, b, c, d, RMD320_F1, 0x00000000U,  6,  7); \
+  RMD320_S(d, e, a, b, c, RMD320_F1, 0x00000000U,  7,  9); \
+  RMD320_S(c, d, e, a, b, RMD320_F1, 0x00000000U,  8, 11); \
+  RMD320_S(b, c, d, e, a, RMD320_F1, 0x00000000U,  9, 13); \
+  RMD320_S(a, b, c, d, e, RMD320_F1, 0x00000000U, 10, 14); \
+  RMD320_S(e, a, b, c, d, RMD320_F1, 0x00000000U, 11, 15); \
+  RMD320_S(d, e, a, b, c, RMD320_F1, 0x00000000U, 12,  6); \
+  RMD320_S(c, d, e, a, b, RMD320_F1, 0x00000000U, 13,  7); \
+  RMD320_S(b, c, d, e, a, RMD320_F1, 0x00000000U, 14,  9); \
+  RMD320_S(a, b, c, d, e, RMD320_F1, 0x00000000U, 15,  8)
+
+#define RMD320_R1(a, b, c, d, e) \
+  RMD320_S(a, b, c, d, e, RMD320_F5, 0x50a28be6U,  5,  8); \
+  RMD320_S(e, a, b, c, d, RMD320_F5, 0x50a28be6U, 14,  9); \
+  RMD320_S(d, e, a, b, c, RMD320_F5, 0x50a28be6U,  7,  9); \
+  RMD320_S(c, d, e, a, b, RMD320_F5, 0x50a28be6U,  0, 11); \
+  RMD320_S(b, c, d, e, a, RMD320_F5, 0x50a28be6U,  9, 13); \
+  RMD320_S(a, b, c, d, e, RMD320_F5, 0x50a28be6U,  2, 15); \
+  RMD320_S(e, a, b, c, d, RMD320_F5, 0x50a28be6U, 11, 15); \
+  RMD320_S(d, e, a, b, c, RMD320_F5, 0x50a28be6U,  4,  5); \
+  RMD320_S(c, d, e, a, b, RMD320_F5, 0x50a28be6U, 13,  7); \
+  RMD320_S(b, c, d, e, a, RMD320_F5, 0x50a28be6U,  6,  7); \
+  RMD320_S(a, b, c, d, e, RMD320_F5, 0x50a28be6U, 15,  8); \
+  RMD320_S(e, a, b, c, d, RMD320_F5, 0x50a28be6U,  8, 11); \
+  RMD320_S(d, e, a, b, c, RMD320_F5, 0x50a28be6U,  1, 14); \
+  RMD320_S(c, d, e, a, b, RMD320_F5, 0x50a28be6U, 10, 14); \
+  RMD320_S(b, c, d, e, a, RMD320_F5, 0x50a28be6U,  3, 12); \
+  RMD320_S(a, b, c, d, e, RMD320_F5, 0x50a28be6U, 12,  6)
+
+#define RMD320_L2(a, b, c, d, e) \
+  RMD320_S(a, b, c, d, e, RMD320_F2, 0x5a827999U,  7,  7); \
+  RMD320_S(e, a, b, c, d, RMD320_F2, 0x5a827999U,  4,  6); \
+  RMD320_S(d, e, a, b, c, RMD320_F2, 0x5a827999U, 13,  8); \
+  RMD320_S(c, d, e, a, b, RMD320_F2, 0x5a827999U,  1, 13); \
+  RMD320_S(b, c, d, e, a, RMD320_F2, 0x5a827999U, 10, 11); \
+  RMD320_S(a, b, c, d, e, RMD320_F2, 0x5a827999U,  6,  9); \
+  RMD320_S(e, a, b, c, d, RMD320_F2, 0x5a827999U, 15,  7); \
+  RMD320_S(d, e, a, b, c, RMD320_F2, 0x5a827999U,  3, 15); \
+  RMD320_S(c, d, e, a, b, RMD320_F2, 0x5a827999U, 12,  7); \
+  RMD320_S(b, c, d, e, a, RMD320_F2, 0x5a827999U,  0, 12); \
+  RMD320_S(a, b, c, d, e, RMD320_F2, 0x5a827999U,  9, 15); \
+  RMD320_S(e, a, b, c, d, RMD320_F2, 0x5a827999U,  5,  9); \
+  RMD320_S(d, e, a, b, c, RMD320_F2, 0x5a827999U,  2, 11); \
+  RMD320_S(c, d, e, a, b, RMD320_F2, 0x5a827999U, 14,  7); \
+  RMD320_S(b, c, d, e, a, RMD320_F2, 0x5a827999U, 11, 13); \
+  RMD320_S(a, b, c, d, e, RMD320_F2, 0x5a827999U,  8, 12)
+
+#define RMD320_R2(a, b, c, d, e) \
+  RMD320_S(a, b, c, d, e, RMD320_F4, 0x5c4dd124U,  6,  9); \
+  RMD320_S(e, a, b, c, d, RMD320_F4, 0x5c4dd124U, 11, 13); \
+  RMD320_S(d, e, a, b, c, RMD320_F4, 0x5c4dd124U,  3, 15); \
+  RMD320_S(c, d, e, a, b, RMD320_F4, 0x5c4dd124U,  7,  7); \
+  RMD320_S(b, c, d, e, a, RMD320_F4, 0x5c4dd124U,  0, 12); \
+  RMD320_S(a, b, c, d, e, RMD320_F4, 0x5c4dd124U, 13,  8); \
+  RMD320_S(e, a, b, c, d, RMD320_F4, 0x5c4dd124U,  5,  9); \
+  RMD320_S(d, e, a, b, c, RMD320_F4, 0x5c4dd124U, 10, 11); \
+  RMD320_S(c, d, e, a, b, RMD320_F4, 0x5c4dd124U, 14,  7); \
+  RMD320_S(b, c, d, e, a, RMD320_F4, 0x5c4dd124U, 15,  7); \
+  RMD320_S(a, b, c, d, e, RMD320_F4, 0x5c4dd124U,  8, 12); \
+  RMD320_S(e, a, b, c, d, RMD320_F4, 0x5c4dd124U, 12,  7); \
+  RMD320_S(d, e, a, b, c, RMD320_F4, 0x5c4dd124U,  4,  6); \
+  RMD320_S(c, d, e, a, b, RMD320_F4, 0x5c4dd124U,  9, 15); \
+  RMD320_S(b, c, d, e, a, RMD320_F4, 0x5c4dd124U,  1, 13); \
+  RMD320_S(a, b, c, d, e, RMD320_F4, 0x5c4dd124U,  2, 11)
+
+#define RMD320_L3(a, b, c, d, e) \
+  RMD320_S(a, b, c, d, e, RMD320_F3, 0x6ed9eba1U,  3, 11); \
+  RMD320_S(e, a, b, c, d, RMD320_F3, 0x6ed9eba1U, 10, 13); \
+  RMD320_S(d, e, a, b, c, RMD320_F3, 0x6ed9eba1U, 14,  6); \
+  RMD320_S(c, d, e, a, b, RMD320_F3, 0x6ed9eba1U,  4,  7); \
+  RMD320_S(b, c, d, e, a, RMD320_F3, 0x6ed9eba1U,  9, 14); \
+  RMD320_S(a, b, c, d, e, RMD320_F3, 0x6ed9eba1U, 15,  9); \
+  RMD320_S(e, a, b, c, d, RMD320_F3, 0x6ed9eba1U,  8, 13); \
+  RMD320_S(d, e, a, b, c, RMD320_F3, 0x6ed9eba1U,  1, 15); \
+  RMD320_S(c, d, e, a, b, RMD320_F3, 0x6ed9eba1U,  2, 14); \
+  RMD320_S(b, c, d, e, a, RMD320_F3, 0x6ed9eba1U,  7,  8); \
+  RMD320_S(a, b, c, d, e, RMD320_F3, 0x6ed9eba1U,  0, 13); \
+  RMD320_S(e, a, b, c, d, RMD320_F3, 0x6ed9eba1U,  6,  6); \
+  RMD320_S(d, e, a, b, c, RMD320_F3, 0x6ed9eba1U, 13,  5); \
+  RMD320_S(c, d, e, a, b, RMD320_F3, 0x6ed9eba1U, 11, 12); \
+  RMD320_S(b, c, d, e, a, RMD320_F3, 0x6ed9eba1U,  5,  7); \
+  RMD320_S(a, b, c, d, e, RMD320_F3, 0x6ed9eba1U, 12,  5)
+
+#define RMD320_R3(a, b, c, d, e) \
+  RMD320_S(a, b, c, d, e, RMD320_F3, 0x6d703ef3U, 15,  9); \
+  RMD320_S(e, a, b, c, d, RMD320_F3, 0x6d703ef3U,  5,  7); \
+  RMD320_S(d, e, a, b, c, RMD320_F3, 0x6d703ef3U,  1, 15); \
+  RMD320_S(c, d, e, a, b, RMD320_F3, 0x6d703ef3U,  3, 11); \
+  RMD320_S(b, c, d, e, a, RMD320_F3, 0x6d703ef3U,  7,  8); \
+  RMD320_S(a, b, c, d, e, RMD320_F3, 0x6d703ef3U, 14,  6); \
+  RMD320_S(e, a, b, c, d, RMD320_F3, 0x6d703ef3U,  6,  6); \
+  RMD320_S(d, e, a, b, c, RMD320_F3, 0x6d703ef3U,  9, 14); \
+  RMD320_S(c, d, e, a, b, RMD320_F3, 0x6d703ef3U, 11, 12); \
+  RMD320_S(b, c, d, e, a, RMD320_F3, 0x6d703ef3U,  8, 13); \
+  RMD320_S(a, b, c, d, e, RMD320_F3, 0x6d703ef3U, 12,  5); \
+  RMD320_S(e, a, b, c, d, RMD320_F3, 0x6d703ef3U,  2, 14); \
+  RMD320_S(d, e, a, b, c, RMD320_F3, 0x6d703ef3U, 10, 13); \
+  RMD320_S(c, d, e, a, b, RMD320_F3, 0x6d703ef3U,  0, 13); \
+  RMD320_S(b, c, d, e, a, RMD320_F3, 0x6d703ef3U,  4,  7); \
+  RMD320_S(a, b, c, d, e, RMD320_F3, 0x6d703ef3U, 13,  5)
+
+#define RMD320_L4(a, b, c, d, e) \
+  RMD320_S(a, b, c, d, e, RMD320_F4, 0x8f1bbcdcU,  1, 11); \
+  RMD320_S(e, a, b, c, d, RMD320_F4, 0x8f1bbcdcU,  9, 12); \
+  RMD320_S(d, e, a, b, c, RMD320_F4, 0x8f1bbcdcU, 11, 14); \
+  RMD320_S(c, d, e, a, b, RMD320_F4, 0x8f1bbcdcU, 10, 15); \
+  RMD320_S(b, c, d, e, a, RMD320_F4, 0x8f1bbcdcU,  0, 14); \
+  RMD320_S(a, b, c, d, e, RMD320_F4, 0x8f1bbcdcU,  8, 15); \
+  RMD320_S(e, a, b, c, d, RMD320_F4, 0x8f1bbcdcU, 12,  9); \
+  RMD320_S(d, e, a, b, c, RMD320_F4, 0x8f1bbcdcU,  4,  8); \
+  RMD320_S(c, d, e, a, b, RMD320_F4, 0x8f1bbcdcU, 13,  9); \
+  RMD320_S(b, c, d, e, a, RMD320_F4, 0x8f1bbcdcU,  3, 14); \
+  RMD320_S(a, b, c, d, e, RMD320_F4, 0x8f1bbcdcU,  7,  5); \
+  RMD320_S(e, a, b, c, d, RMD320_F4, 0x8f1bbcdcU, 15,  6); \
+  RMD320_S(d, e, a, b, c, RMD320_F4, 0x8f1bbcdcU, 14,  8); \
+  RMD320_S(c, d, e, a, b, RMD320_F4, 0x8f1bbcdcU,  5,  6); \
+  RMD320_S(b, c, d, e, a, RMD320_F4, 0x8f1bbcdcU,  6,  5); \
+  RMD320_S(a, b, c, d, e, RMD320_F4, 0x8f1bbcdcU,  2, 12)
+
+#define RMD320_R4(a, b, c, d, e) \
+  RMD320_S(a, b, c, d, e, RMD320_F2, 0x7a6d76e9U,  8, 15); \
+  RMD320_S(e, a, b, c, d, RMD320_F2, 0x7a6d76e9U,  6,  5); \
+  RMD320_S(d, e, a, b, c, RMD320_F2, 0x7a6d76e9U,  4,  8); \
+  RMD320_S(c, d, e, a, b, RMD320_F2, 0x7a6d76e9U,  1, 11); \
+  RMD320_S(b, c, d, e, a, RMD320_F2, 0x7a6d76e9U,  3, 14); \
+  RMD320_S(a, b, c, d, e, RMD320_F2, 0x7a6d76e9U, 11, 14); \
+  RMD320_S(e, a, b, c, d, RMD320_F2, 0x7a6d76e9U, 15,  6); \
+  RMD320_S(d, e, a, b, c, RMD320_F2, 0x7a6d76e9U,  0, 14); \
+  RMD320_S(c, d, e, a, b, RMD320_F2, 0x7a6d76e9U,  5,  6); \
+  RMD320_S(b, c, d, e, a, RMD320_F2, 0x7a6d76e9U, 12,  9); \
+  RMD320_S(a, b, c, d, e, RMD320_F2, 0x7a6d76e9U,  2, 12); \
+  RMD320_S(e, a, b, c, d, RMD320_F2, 0x7a6d76e9U, 13,  9); \
+  RMD320_S(d, e, a, b, c, RMD320_F2, 0x7a6d76e9U,  9, 12); \
+  RMD320_S(c, d, e, a, b, RMD320_F2, 0x7a6d76e9U,  7,  5); \
+  RMD320_S(b, c, d, e, a, RMD320_F2, 0x7a6d76e9U, 10, 15); \
+  RMD320_S(a, b, c, d, e, RMD320_F2, 0x7a6d76e9U, 14,  8)
+
+#define RMD320_L5(a, b, c, d, e) \
+  RMD320_S(a, b, c, d, e, RMD320_F5, 0xa953fd4eU,  4,  9); \
+  RMD320_S(e, a, b, c, d, RMD320_F5, 0xa953fd4eU,  0, 15); \
+  RMD320_S(d, e, a, b, c, RMD320_F5, 0xa953fd4eU,  5,  5); \
+  RMD320_S(c, d, e, a, b, RMD320_F5, 0xa953fd4eU,  9, 11); \
+  RMD320_S(b, c, d, e, a, RMD320_F5, 0xa953fd4eU,  7,  6); \
+  RMD320_S(a, b, c, d, e, RMD320_F5, 0xa953fd4eU, 12,  8); \
+  RMD320_S(e, a, b, c, d, RMD320_F5, 0xa953fd4eU,  2, 13); \
+  RMD320_S(d, e, a, b, c, RMD320_F5, 0xa953fd4eU, 10, 12); \
+  RMD320_S(c, d, e, a, b, RMD320_F5, 0xa953fd4eU, 14,  5); \
+  RMD320_S(b, c, d, e, a, RMD320_F5, 0xa953fd4eU,  1, 12); \
+  RMD320_S(a, b, c, d, e, RMD320_F5, 0xa953fd4eU,  3, 13); \
+  RMD320_S(e, a, b, c, d, RMD320_F5, 0xa953fd4eU,  8, 14); \
+  RMD320_S(d, e, a, b, c, RMD320_F5, 0xa953fd4eU, 11, 11); \
+  RMD320_S(c, d, e, a, b, RMD320_F5, 0xa953fd4eU,  6,  8); \
+  RMD320_S(b, c, d, e, a, RMD320_F5, 0xa953fd4eU, 15,  5); \
+  RMD320_S(a, b, c, d, e, RMD320_F5, 0xa953fd4eU, 13,  6)
+
+#define RMD320_R5(a, b, c, d, e) \
+  RMD320_S(a, b, c, d, e, RMD320_F1, 0x00000000U, 12,  8); \
+  RMD320_S(e, a, b, c, d, RMD320_F1, 0x00000000U, 15,  5); \
+  RMD320_S(d, e, a, b, c, RMD320_F1, 0x00000000U, 10, 12); \
+  RMD320_S(c, d, e, a, b, RMD320_F1, 0x00000000U,  4,  9); \
+  RMD320_S(b, c, d, e, a, RMD320_F1, 0x00000000U,  1, 12); \
+  RMD320_S(a, b, c, d, e, RMD320_F1, 0x00000000U,  5,  5); \
+  RMD320_S(e, a, b, c, d, RMD320_F1, 0x00000000U,  8, 14); \
+  RMD320_S(d, e, a, b, c, RMD320_F1, 0x00000000U,  7,  6); \
+  RMD320_S(c, d, e, a, b, RMD320_F1, 0x00000000U,  6,  8); \
+  RMD320_S(b, c, d, e, a, RMD320_F1, 0x00000000U,  2, 13); \
+  RMD320_S(a, b, c, d, e, RMD320_F1, 0x00000000U, 13,  6); \
+  RMD320_S(e, a, b, c, d, RMD320_F1, 0x00000000U, 14,  5); \
+  RMD320_S(d, e, a, b, c, RMD320_F1, 0x00000000U,  0, 15); \
+  RMD320_S(c, d, e, a, b, RMD320_F1, 0x00000000U,  3, 13); \
+  RMD320_S(b, c, d, e, a, RMD320_F1, 0x00000000U,  9, 11); \
+  RMD320_S(a, b, c, d, e, RMD320_F1, 0x00000000U, 11, 11)
+
+#if defined(RMD320_DISPATCH) || (defined(RMD320_UNROLL) && !defined(RMD320_AVX512VL))
+
+/* speed profile */
+#define RMD320_ADD(x, y) ((x) + (y))
+#define RMD320_ROL(x, n) (((x) << (n)) | ((x) >> (sizeof (rmd320_bt) * 8 - (n))))
+#define RMD320_K(k) (k)
+#define RMD320_F1(x, y, z) ((x) ^ (y) ^ (z))                /* x XOR y XOR z */
+#define RMD320_F2(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))      /* (x AND y) OR (NOT(x) AND z) */
+#define RMD320_F3(x, y, z) (((x) | ~(y)) ^ (z))             /* (x OR NOT(y)) XOR z */
+#define RMD320_F4(x, y, z) ((y) ^ ((z) & ((x) ^ (y))))      /* (x AND z) OR (y AND NOT(z)) */
+#define RMD320_F5(x, y, z) ((x) ^ ((y) | ~(z)))             /* x XOR (y OR NOT(z)) */
+
+/* the chaining value stays in h0..h9 across all n blocks */
+static void
+rmd320mixu(
+  rmd320_bt h[]
+ ,const unsigned char x[]
+ ,size_t n
 ){
-  v->h[0] = 0x67452301U;
-  v->h[1] = 0xefcdab89U;
-  v->h[2] = 0x98badcfeU;
-  v->h[3] = 0x10325476U;
-  v->h[4] = 0xc3d2e1f0U;
-  v->h[5] = 0x76543210U;
-  v->h[6] = 0xfedcba98U;
-  v->h[7] = 0x89abcdefU;
-  v->h[8] = 0x01234567U;
-  v->h[9] = 0x3c2d1e0fU;
-  v->bh = v->bl = 0;
-  v->l = 0;
+  rmd320_bt w[16]; /* precomputed message words */
+  rmd320_bt h0, h1, h2, h3, h4, h5, h6, h7, h8, h9;
+  rmd320_bt al, bl, cl, dl, el;
+  rmd320_bt ar, br, cr, dr, er;
+  rmd320_bt f;
+  unsigned int i;
+
+  h0 = h[0];
+  h1 = h[1];
+  h2 = h[2];
+  h3 = h[3];
+  h4 = h[4];
+  h5 = h[5];
+  h6 = h[6];
+  h7 = h[7];
+  h8 = h[8];
+  h9 = h[9];
+  for (; n; --n, x += 64) {
+    for (i = 0; i < 16; ++i)
+      w[i] = (rmd320_bt)x[i * 4] | (rmd320_bt)x[i * 4 + 1] << 8
+           | (rmd320_bt)x[i * 4 + 2] << 16 | (rmd320_bt)x[i * 4 + 3] << 24;
+    al = h0;
+    bl = h1;
+    cl = h2;
+    dl = h3;
+    el = h4;
+    ar = h5;
+    br = h6;
+    cr = h7;
+    dr = h8;
+    er = h9;
+    RMD320_L1(al, bl, cl, dl, el);
+    RMD320_R1(ar, br, cr, dr, er);
+    f = al; al = ar; ar = f;
+    RMD320_L2(el, al, bl, cl, dl);
+    RMD320_R2(er, ar, br, cr, dr);
+    f = bl; bl = br; br = f;
+    RMD320_L3(dl, el, al, bl, cl);
+    RMD320_R3(dr, er, ar, br, cr);
+    f = cl; cl = cr; cr = f;
+    RMD320_L4(cl, dl, el, al, bl);
+    RMD320_R4(cr, dr, er, ar, br);
+    f = dl; dl = dr; dr = f;
+    RMD320_L5(bl, cl, dl, el, al);
+    RMD320_R5(br, cr, dr, er, ar);
+    f = el; el = er; er = f;
+    h0 = RMD320_ADD(h0, al);
+    h1 = RMD320_ADD(h1, bl);
+    h2 = RMD320_ADD(h2, cl);
+    h3 = RMD320_ADD(h3, dl);
+    h4 = RMD320_ADD(h4, el);
+    h5 = RMD320_ADD(h5, ar);
+    h6 = RMD320_ADD(h6, br);
+    h7 = RMD320_ADD(h7, cr);
+    h8 = RMD320_ADD(h8, dr);
+    h9 = RMD320_ADD(h9, er);
+  }
+  h[0] = h0;
+  h[1] = h1;
+  h[2] = h2;
+  h[3] = h3;
+  h[4] = h4;
+  h[5] = h5;
+  h[6] = h6;
+  h[7] = h7;
+  h[8] = h8;
+  h[9] = h9;
 }
 
+#undef RMD320_ADD
+#undef RMD320_ROL
+#undef RMD320_K
+#undef RMD320_F1
+#undef RMD320_F2
+#undef RMD320_F3
+#undef RMD320_F4
+#undef RMD320_F5
+
+#endif /* RMD320_DISPATCH || (RMD320_UNROLL && !RMD320_AVX512VL) */
+
+#if !defined(RMD320_UNROLL) || defined(RMD320_DISPATCH)
+
+/* size profile */
 static void
-rmd320mix(
+rmd320mixl(
   rmd320_bt h[]
  ,const unsigned char x[]
+ ,size_t n
 ){
   static const rmd320_bt k[10] = { /* added constants */
     0x00000000U
@@ -104,82 +417,582 @@ rmd320mix(
   unsigned int base, phase, jm;
   unsigned int a, b, c, d, e;
 
-  for (i = 0; i < 16; ++i)
-    w[i] = (rmd320_bt)x[i * 4] | (rmd320_bt)x[i * 4 + 1] << 8
-         | (rmd320_bt)x[i * 4 + 2] << 16 | (rmd320_bt)x[i * 4 + 3] << 24;
-  for (i = 0; i < 10; ++i)
-    t[i] = h[i];
-  for (i = 0; i < 10; ++i) {
-    base = (i & 1) * 5;
-    phase = i >> 1;
-    for (j = 0; j < 16; ++j) {
-      jm = (j + phase) % 5;
-      a = base + (5u - jm) % 5;
-      b = base + (6u - jm) % 5;
-      c = base + (7u - jm) % 5;
-      d = base + (8u - jm) % 5;
-      e = base + (9u - jm) % 5;
+  for (; n; --n, x += 64) {
+    for (i = 0; i < 16; ++i)
+      w[i] = (rmd320_bt)x[i * 4] | (rmd320_bt)x[i * 4 + 1] << 8
+           | (rmd320_bt)x[i * 4 + 2] << 16 | (rmd320_bt)x[i * 4 + 3] << 24;
+    for (i = 0; i < 10; ++i)
+      t[i] = h[i];
+    for (i = 0; i < 10; ++i) {
+      base = (i & 1) * 5;
+      phase = i >> 1;
+      for (j = 0; j < 16; ++j) {
+        jm = (j + phase) % 5;
+        a = base + (5u - jm) % 5;
+        b = base + (6u - jm) % 5;
+        c = base + (7u - jm) % 5;
+        d = base + (8u - jm) % 5;
+        e = base + (9u - jm) % 5;
+        switch (i) {
+        case 0: case 9: /* x XOR y XOR z */
+          f = t[b] ^ t[c] ^ t[d];
+          break;
+        case 2: case 7: /* (x AND y) OR (NOT(x) AND z) */
+          f = t[d] ^ (t[b] & (t[c] ^ t[d]));
+          break;
+        case 4: case 5: /* (x OR NOT(y)) XOR z */
+          f = (t[b] | ~t[c]) ^ t[d];
+          break;
+        case 6: case 3: /* (x AND z) OR (y AND NOT(z)) */
+          f = t[c] ^ (t[d] & (t[b] ^ t[c]));
+          break;
+        case 8: case 1: /* x XOR (y OR NOT(z)) */
+          f = t[b] ^ (t[c] | ~t[d]);
+          break;
+        }
+        f += t[a] + w[r[i][j]] + k[i];
+        t[a] = ((f << s[i][j]) | (f >> (sizeof (rmd320_bt) * 8 - s[i][j]))) /* rotate left */
+             + t[e];
+        t[c] = (t[c] << 10) | (t[c] >> (sizeof (rmd320_bt) * 8 - 10)); /* rotate left */
+      }
       switch (i) {
-      case 0: case 9: /* x XOR y XOR z */
-        f = t[b] ^ t[c] ^ t[d];
+      case 1:
+        f = t[0];
+        t[0] = t[5];
+        t[5] = f;
+        break;
+      case 3:
+        f = t[1];
+        t[1] = t[6];
+        t[6] = f;
         break;
-      case 2: case 7: /* (x AND y) OR (NOT(x) AND z) */
-        f = t[d] ^ (t[b] & (t[c] ^ t[d]));
+      case 5:
+        f = t[2];
+        t[2] = t[7];
+        t[7] = f;
         break;
-      case 4: case 5: /* (x OR NOT(y)) XOR z */
-        f = (t[b] | ~t[c]) ^ t[d];
+      case 7:
+        f = t[3];
+        t[3] = t[8];
+        t[8] = f;
         break;
-      case 6: case 3: /* (x AND z) OR (y AND NOT(z)) */
-        f = t[c] ^ (t[d] & (t[b] ^ t[c]));
+      case 9:
+        f = t[4];
+        t[4] = t[9];
+        t[9] = f;
         break;
-      case 8: case 1: /* x XOR (y OR NOT(z)) */
-        f = t[b] ^ (t[c] | ~t[d]);
+      default:
         break;
       }
-      f += t[a] + w[r[i][j]] + k[i];
-      t[a] = ((f << s[i][j]) | (f >> (sizeof (rmd320_bt) * 8 - s[i][j]))) /* rotate left */
-           + t[e];
-      t[c] = (t[c] << 10) | (t[c] >> (sizeof (rmd320_bt) * 8 - 10)); /* rotate left */
     }
-    switch (i) {
-    case 1:
-      f = t[0];
-      t[0] = t[5];
-      t[5] = f;
-      break;
-    case 3:
-      f = t[1];
-      t[1] = t[6];
-      t[6] = f;
-      break;
-    case 5:
-      f = t[2];
-      t[2] = t[7];
-      t[7] = f;
-      break;
-    case 7:
-      f = t[3];
-      t[3] = t[8];
-      t[8] = f;
-      break;
-    case 9:
-      f = t[4];
-      t[4] = t[9];
-      t[9] = f;
-      break;
-    default:
+    for (i = 0; i < 10; ++i)
+      h[i] += t[i];
+  }
+}
+
+#endif /* !RMD320_UNROLL || RMD320_DISPATCH */
+
+#if (defined(RMD320_UNROLL) || defined(RMD320_DISPATCH)) && defined(RMD320_AVX512VL)
+
+/*
+ * Paired step sequences: step j of the left line and step j of the right
+ * line as one step on a register whose lane 0 is the left line and lane 1
+ * the right, each with its own message word and rotate amount.
+ * The lines share the a..e role rotation, only the round functions and
+ * added constants differ.
+ */
+#define RMD320_T(a, b, c, d, e, g, xl, sl, xr, sr) \
+  a = _mm_add_epi32(_mm_add_epi32(a, RMD320_W(xl, xr)), g(b, c, d)); \
+  a = _mm_add_epi32(_mm_rolv_epi32(a, _mm_set_epi32(0, 0, sr, sl)), e); \
+  c = _mm_rol_epi32(c, 10)
+
+#define RMD320_P1(a, b, c, d, e) \
+  RMD320_T(a, b, c, d, e, RMD320_G1,  0, 11,  5,  8); \
+  RMD320_T(e, a, b, c, d, RMD320_G1,  1, 14, 14,  9); \
+  RMD320_T(d, e, a, b, c, RMD320_G1,  2, 15,  7,  9); \
+  RMD320_T(c, d, e, a, b, RMD320_G1,  3, 12,  0, 11); \
+  RMD320_T(b, c, d, e, a, RMD320_G1,  4,  5,  9, 13); \
+  RMD320_T(a, b, c, d, e, RMD320_G1,  5,  8,  2, 15); \
+  RMD320_T(e, a, b, c, d, RMD320_G1,  6,  7, 11, 15); \
+  RMD320_T(d, e, a, b, c, RMD320_G1,  7,  9,  4,  5); \
+  RMD320_T(c, d, e, a, b, RMD320_G1,  8, 11, 13,  7); \
+  RMD320_T(b, c, d, e, a, RMD320_G1,  9, 13,  6,  7); \
+  RMD320_T(a, b, c, d, e, RMD320_G1, 10, 14, 15,  8); \
+  RMD320_T(e, a, b, c, d, RMD320_G1, 11, 15,  8, 11); \
+  RMD320_T(d, e, a, b, c, RMD320_G1, 12,  6,  1, 14); \
+  RMD320_T(c, d, e, a, b, RMD320_G1, 13,  7, 10, 14); \
+  RMD320_T(b, c, d, e, a, RMD320_G1, 14,  9,  3, 12); \
+  RMD320_T(a, b, c, d, e, RMD320_G1, 15,  8, 12,  6)
+
+#define RMD320_P2(a, b, c, d, e) \
+  RMD320_T(a, b, c, d, e, RMD320_G2,  7,  7,  6,  9); \
+  RMD320_T(e, a, b, c, d, RMD320_G2,  4,  6, 11, 13); \
+  RMD320_T(d, e, a, b, c, RMD320_G2, 13,  8,  3, 15); \
+  RMD320_T(c, d, e, a, b, RMD320_G2,  1, 13,  7,  7); \
+  RMD320_T(b, c, d, e, a, RMD320_G2, 10, 11,  0, 12); \
+  RMD320_T(a, b, c, d, e, RMD320_G2,  6,  9, 13,  8); \
+  RMD320_T(e, a, b, c, d, RMD320_G2, 15,  7,  5,  9); \
+  RMD320_T(d, e, a, b, c, RMD320_G2,  3, 15, 10, 11); \
+  RMD320_T(c, d, e, a, b, RMD320_G2, 12,  7, 14,  7); \
+  RMD320_T(b, c, d, e, a, RMD320_G2,  0, 12, 15,  7); \
+  RMD320_T(a, b, c, d, e, RMD320_G2,  9, 15,  8, 12); \
+  RMD320_T(e, a, b, c, d, RMD320_G2,  5,  9, 12,  7); \
+  RMD320_T(d, e, a, b, c, RMD320_G2,  2, 11,  4,  6); \
+  RMD320_T(c, d, e, a, b, RMD320_G2, 14,  7,  9, 15); \
+  RMD320_T(b, c, d, e, a, RMD320_G2, 11, 13,  1, 13); \
+  RMD320_T(a, b, c, d, e, RMD320_G2,  8, 12,  2, 11)
+
+#define RMD320_P3(a, b, c, d, e) \
+  RMD320_T(a, b, c, d, e, RMD320_G3,  3, 11, 15,  9); \
+  RMD320_T(e, a, b, c, d, RMD320_G3, 10, 13,  5,  7); \
+  RMD320_T(d, e, a, b, c, RMD320_G3, 14,  6,  1, 15); \
+  RMD320_T(c, d, e, a, b, RMD320_G3,  4,  7,  3, 11); \
+  RMD320_T(b, c, d, e, a, RMD320_G3,  9, 14,  7,  8); \
+  RMD320_T(a, b, c, d, e, RMD320_G3, 15,  9, 14,  6); \
+  RMD320_T(e, a, b, c, d, RMD320_G3,  8, 13,  6,  6); \
+  RMD320_T(d, e, a, b, c, RMD320_G3,  1, 15,  9, 14); \
+  RMD320_T(c, d, e, a, b, RMD320_G3,  2, 14, 11, 12); \
+  RMD320_T(b, c, d, e, a, RMD320_G3,  7,  8,  8, 13); \
+  RMD320_T(a, b, c, d, e, RMD320_G3,  0, 13, 12,  5); \
+  RMD320_T(e, a, b, c, d, RMD320_G3,  6,  6,  2, 14); \
+  RMD320_T(d, e, a, b, c, RMD320_G3, 13,  5, 10, 13); \
+  RMD320_T(c, d, e, a, b, RMD320_G3, 11, 12,  0, 13); \
+  RMD320_T(b, c, d, e, a, RMD320_G3,  5,  7,  4,  7); \
+  RMD320_T(a, b, c, d, e, RMD320_G3, 12,  5, 13,  5)
+
+#define RMD320_P4(a, b, c, d, e) \
+  RMD320_T(a, b, c, d, e, RMD320_G4,  1, 11,  8, 15); \
+  RMD320_T(e, a, b, c, d, RMD320_G4,  9, 12,  6,  5); \
+  RMD320_T(d, e, a, b, c, RMD320_G4, 11, 14,  4,  8); \
+  RMD320_T(c, d, e, a, b, RMD320_G4, 10, 15,  1, 11); \
+  RMD320_T(b, c, d, e, a, RMD320_G4,  0, 14,  3, 14); \
+  RMD320_T(a, b, c, d, e, RMD320_G4,  8, 15, 11, 14); \
+  RMD320_T(e, a, b, c, d, RMD320_G4, 12,  9, 15,  6); \
+  RMD320_T(d, e, a, b, c, RMD320_G4,  4,  8,  0, 14); \
+  RMD320_T(c, d, e, a, b, RMD320_G4, 13,  9,  5,  6); \
+  RMD320_T(b, c, d, e, a, RMD320_G4,  3, 14, 12,  9); \
+  RMD320_T(a, b, c, d, e, RMD320_G4,  7,  5,  2, 12); \
+  RMD320_T(e, a, b, c, d, RMD320_G4, 15,  6, 13,  9); \
+  RMD320_T(d, e, a, b, c, RMD320_G4, 14,  8,  9, 12); \
+  RMD320_T(c, d, e, a, b, RMD320_G4,  5,  6,  7,  5); \
+  RMD320_T(b, c, d, e, a, RMD320_G4,  6,  5, 10, 15); \
+  RMD320_T(a, b, c, d, e, RMD320_G4,  2, 12, 14,  8)
+
+#define RMD320_P5(a, b, c, d, e) \
+  RMD320_T(a, b, c, d, e, RMD320_G5,  4,  9, 12,  8); \
+  RMD320_T(e, a, b, c, d, RMD320_G5,  0, 15, 15,  5); \
+  RMD320_T(d, e, a, b, c, RMD320_G5,  5,  5, 10, 12); \
+  RMD320_T(c, d, e, a, b, RMD320_G5,  9, 11,  4,  9); \
+  RMD320_T(b, c, d, e, a, RMD320_G5,  7,  6,  1, 12); \
+  RMD320_T(a, b, c, d, e, RMD320_G5, 12,  8,  5,  5); \
+  RMD320_T(e, a, b, c, d, RMD320_G5,  2, 13,  8, 14); \
+  RMD320_T(d, e, a, b, c, RMD320_G5, 10, 12,  7,  6); \
+  RMD320_T(c, d, e, a, b, RMD320_G5, 14,  5,  6,  8); \
+  RMD320_T(b, c, d, e, a, RMD320_G5,  1, 12,  2, 13); \
+  RMD320_T(a, b, c, d, e, RMD320_G5,  3, 13, 13,  6); \
+  RMD320_T(e, a, b, c, d, RMD320_G5,  8, 14, 14,  5); \
+  RMD320_T(d, e, a, b, c, RMD320_G5, 11, 11,  0, 15); \
+  RMD320_T(c, d, e, a, b, RMD320_G5,  6,  8,  3, 13); \
+  RMD320_T(b, c, d, e, a, RMD320_G5, 15,  5,  9, 11); \
+  RMD320_T(a, b, c, d, e, RMD320_G5, 13,  6, 11, 11)
+
+/*
+ * Lane 0 takes the left function and lane 1 the right: with a lane select
+ * (0 left, all ones right) one ternary op each gives g(0, c, d) and
+ * g(1, c, d) ahead of time, and b, the word written by the step before,
+ * only picks between them.
+ * In rounds 1 and 5 both functions are b XOR a function of c and d, so b
+ * is XORed in, and round 3 has one function for both lanes.
+ * b is never the destination operand, so it is not copied first.
+ */
+#define RMD320_SEL _mm_set_epi32(0, 0, -1, 0)
+#define RMD320_G(b, c, d, p, q) \
+  _mm_ternarylogic_epi32(_mm_ternarylogic_epi32(RMD320_SEL, c, d, q), b, _mm_ternarylogic_epi32(RMD320_SEL, c, d, p), 0xe2)
+#define RMD320_G1(b, c, d) _mm_xor_si128(_mm_ternarylogic_epi32(RMD320_SEL, c, d, 0xd6), b) /* F1 | F5 */
+#define RMD320_G2(b, c, d) RMD320_G(b, c, d, 0x4a, 0xec)                                      /* F2 | F4 */
+#define RMD320_G3(b, c, d) _mm_ternarylogic_epi32(d, b, c, 0x2d)                              /* F3 | F3 */
+#define RMD320_G4(b, c, d) RMD320_G(b, c, d, 0xa4, 0xce)                                      /* F4 | F2 */
+#define RMD320_G5(b, c, d) _mm_xor_si128(_mm_ternarylogic_epi32(RMD320_SEL, c, d, 0x6d), b) /* F5 | F1 */
+
+/* message word xl plus the left constant, xr plus the right one */
+#define RMD320_W(xl, xr) \
+  _mm512_castsi512_si128(_mm512_permutex2var_epi32(wl, _mm512_zextsi128_si512(_mm_set_epi32(0, 0, 16 + xr, xl)), wr))
+#define RMD320_WK(kl, kr) \
+  wl = _mm512_add_epi32(w, _mm512_set1_epi32((int)(kl))); \
+  wr = _mm512_add_epi32(w, _mm512_set1_epi32((int)(kr)))
+
+/* the swap of a word between the lines after each round is a lane swap */
+#define RMD320_X(a) a = _mm_shuffle_epi32(a, 0xe1)
+
+/*
+ * One message with both lines in two lanes of one register, each step
+ * issued once for both: for single stream hashing, where there is nothing
+ * to batch and the step to step chain sets the pace.
+ */
+RMD320_AVX512VL static void
+rmd320mix2(
+  rmd320_bt h[]
+ ,const unsigned char x[]
+ ,size_t n
+){
+  __m512i w, wl, wr;
+  __m128i h0, h1, h2, h3, h4; /* h0..h4 in lane 0, h5..h9 in lane 1 */
+  __m128i a, b, c, d, e;
+
+  h0 = _mm_set_epi32(0, 0, (int)h[5], (int)h[0]);
+  h1 = _mm_set_epi32(0, 0, (int)h[6], (int)h[1]);
+  h2 = _mm_set_epi32(0, 0, (int)h[7], (int)h[2]);
+  h3 = _mm_set_epi32(0, 0, (int)h[8], (int)h[3]);
+  h4 = _mm_set_epi32(0, 0, (int)h[9], (int)h[4]);
+  for (; n; --n, x += 64) {
+    w = _mm512_loadu_si512((const void *)x); /* x86 is little endian */
+    a = h0;
+    b = h1;
+    c = h2;
+    d = h3;
+    e = h4;
+    RMD320_WK(0x00000000U, 0x50a28be6U);
+    RMD320_P1(a, b, c, d, e);
+    RMD320_X(a);
+    RMD320_WK(0x5a827999U, 0x5c4dd124U);
+    RMD320_P2(e, a, b, c, d);
+    RMD320_X(b);
+    RMD320_WK(0x6ed9eba1U, 0x6d703ef3U);
+    RMD320_P3(d, e, a, b, c);
+    RMD320_X(c);
+    RMD320_WK(0x8f1bbcdcU, 0x7a6d76e9U);
+    RMD320_P4(c, d, e, a, b);
+    RMD320_X(d);
+    RMD320_WK(0xa953fd4eU, 0x00000000U);
+    RMD320_P5(b, c, d, e, a);
+    RMD320_X(e);
+    h0 = _mm_add_epi32(h0, a);
+    h1 = _mm_add_epi32(h1, b);
+    h2 = _mm_add_epi32(h2, c);
+    h3 = _mm_add_epi32(h3, d);
+    h4 = _mm_add_epi32(h4, e);
+  }
+  h[0] = (rmd320_bt)_mm_extract_epi32(h0, 0);
+  h[1] = (rmd320_bt)_mm_extract_epi32(h1, 0);
+  h[2] = (rmd320_bt)_mm_extract_epi32(h2, 0);
+  h[3] = (rmd320_bt)_mm_extract_epi32(h3, 0);
+  h[4] = (rmd320_bt)_mm_extract_epi32(h4, 0);
+  h[5] = (rmd320_bt)_mm_extract_epi32(h0, 1);
+  h[6] = (rmd320_bt)_mm_extract_epi32(h1, 1);
+  h[7] = (rmd320_bt)_mm_extract_epi32(h2, 1);
+  h[8] = (rmd320_bt)_mm_extract_epi32(h3, 1);
+  h[9] = (rmd320_bt)_mm_extract_epi32(h4, 1);
+}
+
+#endif /* (RMD320_UNROLL || RMD320_DISPATCH) && RMD320_AVX512VL */
+
+#ifdef RMD320_DISPATCH
+static void (*rmd320mix)(rmd320_bt [], const unsigned char [], size_t);
+#elif defined(RMD320_UNROLL) && defined(RMD320_AVX512VL)
+#define rmd320mix rmd320mix2
+#elif defined(RMD320_UNROLL)
+#define rmd320mix rmd320mixu
+#else
+#define rmd320mix rmd320mixl
+#endif
+
+/*
+ * Kernel levels, each a superset of the one before: rmd320mix is the
+ * unrolled kernel from "unroll" up (both lines in one AVX-512VL register
+ * at "avx512") and rmd320x16 runs AVX-512 at "avx512".
+ * Without RMD320_DISPATCH the level is fixed by the compile flags.
+ */
+static const char *const rmd320kn[] = {
+  "loop"
+ ,"unroll"
+ ,"avx512"
+};
+
+/* index of kernel name k in rmd320kn, or the count if unknown */
+static unsigned int
+rmd320kfind(
+  const char *k
+){
+  unsigned int i;
+  unsigned int j;
+
+  for (i = 0; i < sizeof (rmd320kn) / sizeof (rmd320kn[0]); ++i) {
+    for (j = 0; k[j] && k[j] == rmd320kn[i][j]; ++j);
+    if (k[j] == rmd320kn[i][j])
       break;
-    }
   }
-  for (i = 0; i < 10; ++i)
-    h[i] += t[i];
+  return (i);
 }
 
+#ifdef RMD320_DISPATCH
+
+static unsigned int rmd320kl; /* kernel level in use */
+#define RMD320_KL rmd320kl
+#ifdef RMD320_AVX2
+static unsigned int rmd320hv; /* vector hex, above "loop" on an AVX2 CPU */
+#define RMD320_HEXV rmd320hv
+#endif
+
+/* highest level this CPU can run */
+static unsigned int
+rmd320cpu(
+  void
+){
+#ifdef RMD320_AVX512F
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl"))
+    return (2);
+#endif
+  return (1);
+}
+
+/* first use: RMD320_KERNEL from the environment, else the fastest */
+static void
+rmd320auto(
+  void
+){
+  const char *k;
+
+  if (!(k = getenv("RMD320_KERNEL")) || rmd320kernel(k))
+    rmd320kernel(0);
+}
+
+int
+rmd320kernel(
+  const char *k
+){
+  unsigned int i;
+
+  if (!k)
+    i = rmd320cpu();
+  else if ((i = rmd320kfind(k)) > rmd320cpu())
+    return (-1);
+  rmd320kl = i;
+#ifdef RMD320_AVX2
+  rmd320hv = i && __builtin_cpu_supports("avx2"); /* no level of its own */
+#endif
+#ifdef RMD320_AVX512VL
+  rmd320mix = i > 1 ? rmd320mix2 : i ? rmd320mixu : rmd320mixl;
+#else
+  rmd320mix = i ? rmd320mixu : rmd320mixl;
+#endif
+  return (0);
+}
+
+const char *
+rmd320kernelname(
+  void
+){
+  if (!rmd320mix)
+    rmd320auto();
+  return (rmd320kn[rmd320kl]);
+}
+
+#else /* RMD320_DISPATCH */
+
+#if defined(RMD320_AVX512F)
+#define RMD320_KL 2
+#elif defined(RMD320_UNROLL)
+#define RMD320_KL 1
+#else
+#define RMD320_KL 0
+#endif
+#define RMD320_HEXV 1 /* compiled for AVX2 */
+
+int
+rmd320kernel(
+  const char *k
+){
+  if (k && rmd320kfind(k) != RMD320_KL)
+    return (-1);
+  return (0);
+}
+
+const char *
+rmd320kernelname(
+  void
+){
+  return (rmd320kn[RMD320_KL]);
+}
+
+#endif /* RMD320_DISPATCH */
+
 void
-rmd320update(
+rmd320init(
   rmd320_t *v
+){
+#ifdef RMD320_DISPATCH
+  if (!rmd320mix)
+    rmd320auto();
+#endif
+  v->h[0] = 0x67452301U;
+  v->h[1] = 0xefcdab89U;
+  v->h[2] = 0x98badcfeU;
+  v->h[3] = 0x10325476U;
+  v->h[4] = 0xc3d2e1f0U;
+  v->h[5] = 0x76543210U;
+  v->h[6] = 0xfedcba98U;
+  v->h[7] = 0x89abcdefU;
+  v->h[8] = 0x01234567U;
+  v->h[9] = 0x3c2d1e0fU;
+  v->bh = v->bl = 0;
+  v->l = 0;
+}
+
+#ifdef RMD320_AVX512F
+
+/* sixteen lanes of 32 bits, native rotate and three input logic */
+#define RMD320_ADD(x, y) _mm512_add_epi32(x, y)
+#define RMD320_ROL(x, n) _mm512_rol_epi32(x, n)
+#define RMD320_K(k) _mm512_set1_epi32((int)(k))
+#define RMD320_F1(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x96)
+#define RMD320_F2(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xca)
+#define RMD320_F3(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x59)
+#define RMD320_F4(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xe4)
+#define RMD320_F5(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x2d)
+
+/* w[j] holds message word j of every lane's block */
+RMD320_AVX512F static void
+rmd320mix16(
+  __m512i h[]
+ ,const __m512i w[]
+){
+  __m512i al, bl, cl, dl, el;
+  __m512i ar, br, cr, dr, er;
+  __m512i f;
+
+  al = h[0];
+  bl = h[1];
+  cl = h[2];
+  dl = h[3];
+  el = h[4];
+  ar = h[5];
+  br = h[6];
+  cr = h[7];
+  dr = h[8];
+  er = h[9];
+  RMD320_L1(al, bl, cl, dl, el);
+  RMD320_R1(ar, br, cr, dr, er);
+  f = al; al = ar; ar = f;
+  RMD320_L2(el, al, bl, cl, dl);
+  RMD320_R2(er, ar, br, cr, dr);
+  f = bl; bl = br; br = f;
+  RMD320_L3(dl, el, al, bl, cl);
+  RMD320_R3(dr, er, ar, br, cr);
+  f = cl; cl = cr; cr = f;
+  RMD320_L4(cl, dl, el, al, bl);
+  RMD320_R4(cr, dr, er, ar, br);
+  f = dl; dl = dr; dr = f;
+  RMD320_L5(bl, cl, dl, el, al);
+  RMD320_R5(br, cr, dr, er, ar);
+  f = el; el = er; er = f;
+  h[0] = RMD320_ADD(h[0], al);
+  h[1] = RMD320_ADD(h[1], bl);
+  h[2] = RMD320_ADD(h[2], cl);
+  h[3] = RMD320_ADD(h[3], dl);
+  h[4] = RMD320_ADD(h[4], el);
+  h[5] = RMD320_ADD(h[5], ar);
+  h[6] = RMD320_ADD(h[6], br);
+  h[7] = RMD320_ADD(h[7], cr);
+  h[8] = RMD320_ADD(h[8], dr);
+  h[9] = RMD320_ADD(h[9], er);
+}
+
+#undef RMD320_ADD
+#undef RMD320_ROL
+#undef RMD320_K
+#undef RMD320_F1
+#undef RMD320_F2
+#undef RMD320_F3
+#undef RMD320_F4
+#undef RMD320_F5
+
+/* transpose a 64 byte block from each of sixteen lanes into w[16] */
+RMD320_AVX512F static void
+rmd320load16(
+  __m512i w[]
+ ,const unsigned char *const q[]
+){
+  __m512i r[16];
+  __m512i t[16];
+  unsigned int i;
+
+  for (i = 0; i < 16; ++i)
+    r[i] = _mm512_loadu_si512((const void *)q[i]);
+  for (i = 0; i < 16; i += 2) {
+    t[i] = _mm512_unpacklo_epi32(r[i], r[i + 1]);
+    t[i + 1] = _mm512_unpackhi_epi32(r[i], r[i + 1]);
+  }
+  for (i = 0; i < 16; i += 4) { /* r[i + k] quarter q holds word 4q+k of lanes i..i+3 */
+    r[i] = _mm512_unpacklo_epi64(t[i], t[i + 2]);
+    r[i + 1] = _mm512_unpackhi_epi64(t[i], t[i + 2]);
+    r[i + 2] = _mm512_unpacklo_epi64(t[i + 1], t[i + 3]);
+    r[i + 3] = _mm512_unpackhi_epi64(t[i + 1], t[i + 3]);
+  }
+  for (i = 0; i < 4; ++i) {
+    t[0] = _mm512_shuffle_i32x4(r[i], r[4 + i], 0x44);
+    t[1] = _mm512_shuffle_i32x4(r[i], r[4 + i], 0xee);
+    t[2] = _mm512_shuffle_i32x4(r[8 + i], r[12 + i], 0x44);
+    t[3] = _mm512_shuffle_i32x4(r[8 + i], r[12 + i], 0xee);
+    w[i] = _mm512_shuffle_i32x4(t[0], t[2], 0x88);
+    w[4 + i] = _mm512_shuffle_i32x4(t[0], t[2], 0xdd);
+    w[8 + i] = _mm512_shuffle_i32x4(t[1], t[3], 0x88);
+    w[12 + i] = _mm512_shuffle_i32x4(t[1], t[3], 0xdd);
+  }
+}
+
+#endif /* RMD320_AVX512F */
+
+static void
+rmd320len(
+  unsigned char *s
+ ,rmd320_bt bh
+ ,rmd320_bt bl
+){
+  /* bytes to bits * 8=2^3 */
+  *s++ = (unsigned char)(bl << 3);
+  *s++ = (unsigned char)(bl >> (1 * 8 - 3));
+  *s++ = (unsigned char)(bl >> (2 * 8 - 3));
+  *s++ = (unsigned char)(bl >> (3 * 8 - 3));
+  *s++ = (unsigned char)((bh << 3) | (bl >> (4 * 8 - 3)));
+  *s++ = (unsigned char)(bh >> (1 * 8 - 3));
+  *s++ = (unsigned char)(bh >> (2 * 8 - 3));
+  *s   = (unsigned char)(bh >> (3 * 8 - 3));
+}
+
+#ifdef RMD320_AVX512F
+
+/* copy a short (< 64) tail into b[128] and pad it as rmd320final does */
+/* return the number of blocks (1 or 2) in b[] */
+static unsigned int
+rmd320tail(
+  unsigned char *b
  ,const unsigned char *d
  ,unsigned int l
+ ,rmd320_bt bh
+ ,rmd320_bt bl
+){
+  unsigned char *s;
+  unsigned int i;
+  unsigned int n;
+
+  for (i = 0, s = b; i < l; ++i, ++s, ++d)
+    *s = *d;
+  *s++ = 0x80;
+  n = ++i > 64 - 8 ? 128 : 64;
+  for (; i < n - 8; ++i, ++s)
+    *s = 0x00;
+  rmd320len(s, bh, bl);
+  return (n / 64);
+}
+
+#endif /* RMD320_AVX512F */
+
+void
+rmd320updatez(
+  rmd320_t *v
+ ,const unsigned char *d
+ ,size_t l
 ){
   unsigned char *s;
 
@@ -189,7 +1002,7 @@ rmd320update(
     for (i = v->l, s = v->d + i; l && i < 64; --l, ++i, ++s, ++d)
       *s = *d;
     if (i == 64) {
-      rmd320mix(v->h, v->d);
+      rmd320mix(v->h, v->d, 1);
       if ((v->bl += 64) < 64)
         ++v->bh;
       v->l = 0;
@@ -198,18 +1011,107 @@ rmd320update(
       return;
     }
   }
-  for (; l >= 64; l -= 64, d += 64) {
-    rmd320mix(v->h, d);
-    if ((v->bl += 64) < 64)
+  if (l >= 64) {
+    size_t n;
+
+    n = l & ~(size_t)63;
+    rmd320mix(v->h, d, n / 64);
+    if ((v->bl += (rmd320_bt)n) < (rmd320_bt)n)
       ++v->bh;
+    v->bh += (rmd320_bt)(n >> 16 >> 16);
+    l -= n;
+    d += n;
   }
   if (l) {
-    v->l = l;
+    v->l = (unsigned int)l;
     for (s = v->d; l; --l, ++s, ++d)
       *s = *d;
   }
 }
 
+void
+rmd320update(
+  rmd320_t *v
+ ,const unsigned char *d
+ ,unsigned int l
+){
+  rmd320updatez(v, d, l);
+}
+
+void
+rmd320copy(
+  rmd320_t *v
+ ,const rmd320_t *s
+){
+  *v = *s;
+}
+
+/*
+ * Exported state, all little endian: "RMD320", version, pending bytes,
+ * the chaining value, the 64 bit count of bytes compressed and the pending
+ * bytes, zero filled to 64.
+ */
+static const unsigned char rmd320sm[6] = { 'R', 'M', 'D', '3', '2', '0' };
+#define RMD320_STATEV 1
+
+void
+rmd320export(
+  const rmd320_t *v
+ ,unsigned char *s
+){
+  unsigned int i;
+
+  for (i = 0; i < sizeof (rmd320sm); ++i)
+    *s++ = rmd320sm[i];
+  *s++ = RMD320_STATEV;
+  *s++ = (unsigned char)v->l;
+  for (i = 0; i < 10; ++i) {
+    *s++ = (unsigned char)(v->h[i] >> (0 * 8));
+    *s++ = (unsigned char)(v->h[i] >> (1 * 8));
+    *s++ = (unsigned char)(v->h[i] >> (2 * 8));
+    *s++ = (unsigned char)(v->h[i] >> (3 * 8));
+  }
+  for (i = 0; i < 4; ++i)
+    *s++ = (unsigned char)(v->bl >> (i * 8));
+  for (i = 0; i < 4; ++i)
+    *s++ = (unsigned char)(v->bh >> (i * 8));
+  for (i = 0; i < 64; ++i)
+    *s++ = i < v->l ? v->d[i] : 0x00;
+}
+
+int
+rmd320import(
+  rmd320_t *v
+ ,const unsigned char *s
+ ,unsigned long long *n
+){
+  rmd320_bt b[2];
+  unsigned int i;
+
+  for (i = 0; i < sizeof (rmd320sm); ++i)
+    if (s[i] != rmd320sm[i])
+      return (-1);
+  s += sizeof (rmd320sm);
+  if (*s++ != RMD320_STATEV || *s >= 64 || s[41] & 63)
+    return (-1);
+  for (i = *s + 1 + 40 + 8; i < RMD320_STATESZ - sizeof (rmd320sm) - 1; ++i)
+    if (s[i]) /* pending bytes are zero filled */
+      return (-1);
+  rmd320init(v);
+  v->l = *s++;
+  for (i = 0; i < 10; ++i, s += 4)
+    v->h[i] = (rmd320_bt)s[0] | (rmd320_bt)s[1] << 8 | (rmd320_bt)s[2] << 16 | (rmd320_bt)s[3] << 24;
+  for (i = 0; i < 2; ++i, s += 4)
+    b[i] = (rmd320_bt)s[0] | (rmd320_bt)s[1] << 8 | (rmd320_bt)s[2] << 16 | (rmd320_bt)s[3] << 24;
+  v->bl = b[0];
+  v->bh = b[1];
+  for (i = 0; i < v->l; ++i)
+    v->d[i] = s[i];
+  if (n)
+    *n = ((unsigned long long)v->bh << 16 << 16 | v->bl) + v->l;
+  return (0);
+}
+
 void
 rmd320final(
   rmd320_t *v
@@ -226,22 +1128,14 @@ rmd320final(
   if (i > 64 - 8) {
     for (; i < 64; ++i, ++s)
       *s = 0x00;
-    rmd320mix(v->h, v->d);
+    rmd320mix(v->h, v->d, 1);
     i = 0;
     s = v->d;
   }
   for (; i < 64 - 8; ++i, ++s)
     *s = 0x00;
-  /* bytes to bits * 8=2^3 */
-  *s++ = (unsigned char)(v->bl << 3);
-  *s++ = (unsigned char)(v->bl >> (1 * 8 - 3));
-  *s++ = (unsigned char)(v->bl >> (2 * 8 - 3));
-  *s++ = (unsigned char)(v->bl >> (3 * 8 - 3));
-  *s++ = (unsigned char)((v->bh << 3) | (v->bl >> (4 * 8 - 3)));
-  *s++ = (unsigned char)(v->bh >> (1 * 8 - 3));
-  *s++ = (unsigned char)(v->bh >> (2 * 8 - 3));
-  *s   = (unsigned char)(v->bh >> (3 * 8 - 3));
-  rmd320mix(v->h, v->d);
+  rmd320len(s, v->bh, v->bl);
+  rmd320mix(v->h, v->d, 1);
   for (i = 0; i < 10; ++i) {
     *h++ = (unsigned char)(v->h[i] >> (0 * 8));
     *h++ = (unsigned char)(v->h[i] >> (1 * 8));
@@ -250,146 +1144,1144 @@ rmd320final(
   }
 }
 
-void
-rmd320hmac(
-  const unsigned char *k
- ,unsigned int kl
- ,const unsigned char *d
- ,unsigned int dl
+/* wipe stack residue; volatile defeats dead-store elimination */
+static void
+rmd320wipe(
+  void *v
+ ,unsigned int l
+){
+  volatile unsigned char *p;
+
+  for (p = (volatile unsigned char *)v; l; --l)
+    *p++ = 0;
+}
+
+/* start v from the chaining value h with k bytes already compressed */
+static void
+rmd320resume(
+  rmd320_t *v
+ ,const rmd320_bt h[]
+ ,unsigned int k
+){
+  unsigned int i;
+
+  rmd320init(v);
+  for (i = 0; i < 10; ++i)
+    v->h[i] = h[i];
+  v->bl = k;
+}
+
+#ifdef RMD320_AVX512F
+
+RMD320_AVX512F static void
+rmd320x16v(
+  const rmd320_bt *s
+ ,unsigned int k
+ ,const unsigned char *const *d
+ ,const unsigned int *l
  ,unsigned char *h
 ){
-  rmd320_t c;
-  unsigned char i[64];
-  unsigned char o[64];
-  unsigned int l;
+  unsigned char p[16][128]; /* padded tails */
+  const unsigned char *q[16];
+  rmd320_bt o[10][16];
+  unsigned int n[16];       /* whole blocks */
+  unsigned int t[16];       /* total blocks */
+  __m512i v[10];
+  __m512i u[10];
+  __m512i w[16];
+  __m512i e;
+  unsigned int b;
+  unsigned int i;
+  unsigned int z;
 
-  if (kl > 64) {
-    rmd320init(&c);
-    rmd320update(&c, k, kl);
-    rmd320final(&c, h);
-    k = h;
-    kl = RMD320_SZ;
-  }
-  for (l = 0; l < kl; ++l) {
-    i[l] = *(k + l) ^ 0x36;
-    o[l] = *(k + l) ^ 0x5c;
+  for (z = 0, i = 0; i < 16; ++i) {
+    n[i] = l[i] / 64;
+    t[i] = n[i] + rmd320tail(p[i], d[i] + n[i] * 64, l[i] % 64, l[i] + k < k, l[i] + k);
+    if (t[i] > z)
+      z = t[i];
   }
-  for (; l < 64; ++l) {
-    i[l] = 0x00 ^ 0x36;
-    o[l] = 0x00 ^ 0x5c;
-  }
-  rmd320init(&c);
-  rmd320update(&c, i, sizeof (i));
-  rmd320update(&c, d, dl);
-  rmd320final(&c, h);
-  rmd320init(&c);
-  rmd320update(&c, o, sizeof (o));
-  rmd320update(&c, h, RMD320_SZ);
-  rmd320final(&c, h);
-  /* wipe stack residue; volatile defeats dead-store elimination */
-  {
-    volatile unsigned char *p;
-    unsigned int n;
-
-    p = (volatile unsigned char *)&c;
-    for (n = 0; n < sizeof (c); ++n)
-      *p++ = 0;
-    p = (volatile unsigned char *)i;
-    for (n = 0; n < sizeof (i); ++n)
-      *p++ = 0;
-    p = (volatile unsigned char *)o;
-    for (n = 0; n < sizeof (o); ++n)
-      *p++ = 0;
+  e = _mm512_loadu_si512((const void *)t);
+  for (i = 0; i < 10; ++i)
+    v[i] = _mm512_set1_epi32((int)s[i]);
+  for (b = 0; b < z; ++b) {
+    for (i = 0; i < 16; ++i)
+      if (b < n[i])
+        q[i] = d[i] + b * 64;
+      else if (b < t[i])
+        q[i] = p[i] + (b - n[i]) * 64;
+      else
+        q[i] = p[i]; /* lane done, result discarded */
+    rmd320load16(w, q);
+    for (i = 0; i < 10; ++i)
+      u[i] = v[i];
+    rmd320mix16(u, w);
+    for (i = 0; i < 10; ++i)
+      v[i] = _mm512_mask_mov_epi32(v[i], _mm512_cmpgt_epu32_mask(e, _mm512_set1_epi32((int)b)), u[i]);
   }
+  for (i = 0; i < 10; ++i)
+    _mm512_storeu_si512((void *)o[i], v[i]);
+  for (b = 0; b < 16; ++b)
+    for (i = 0; i < 10; ++i) {
+      *h++ = (unsigned char)(o[i][b] >> (0 * 8));
+      *h++ = (unsigned char)(o[i][b] >> (1 * 8));
+      *h++ = (unsigned char)(o[i][b] >> (2 * 8));
+      *h++ = (unsigned char)(o[i][b] >> (3 * 8));
+    }
 }
 
-void
-rmd320hkdf(
-  const unsigned char *k
- ,unsigned int kl
- ,const unsigned char *d
- ,unsigned int dl
- ,unsigned char *s
- ,unsigned int sl
+#endif /* RMD320_AVX512F */
+
+/* initial chaining value, as set by rmd320init */
+static const rmd320_bt rmd320iv[10] = {
+  0x67452301U
+ ,0xefcdab89U
+ ,0x98badcfeU
+ ,0x10325476U
+ ,0xc3d2e1f0U
+ ,0x76543210U
+ ,0xfedcba98U
+ ,0x89abcdefU
+ ,0x01234567U
+ ,0x3c2d1e0fU
+};
+
+/* n messages, each started from chaining value s with k bytes behind it */
+static void
+rmd320xn(
+  const rmd320_bt *s
+ ,unsigned int k
+ ,const unsigned char *const *d
+ ,const unsigned int *l
+ ,unsigned char *h
+ ,unsigned int n
 ){
   rmd320_t c;
-  unsigned char i[64];
-  unsigned char o[64];
+  unsigned int i;
+
+#ifdef RMD320_DISPATCH
+  if (!rmd320mix)
+    rmd320auto();
+#endif
+#ifdef RMD320_AVX512F
+  for (; RMD320_KL >= 2 && n >= 16; n -= 16, d += 16, l += 16, h += 16 * RMD320_SZ)
+    rmd320x16v(s, k, d, l, h);
+  if (RMD320_KL >= 2 && n > 4) { /* fill the idle lanes with the first message */
+    const unsigned char *e[16];
+    unsigned int f[16];
+    unsigned char g[16 * RMD320_SZ];
+
+    for (i = 0; i < 16; ++i) {
+      e[i] = d[i < n ? i : 0];
+      f[i] = l[i < n ? i : 0];
+    }
+    rmd320x16v(s, k, e, f, g);
+    for (i = 0; i < n * RMD320_SZ; ++i)
+      h[i] = g[i];
+    return;
+  }
+#endif
+  for (i = 0; i < n; ++i, h += RMD320_SZ) {
+    rmd320resume(&c, s, k);
+    rmd320update(&c, d[i], l[i]);
+    rmd320final(&c, h);
+  }
+}
+
+void
+rmd320x16(
+  const unsigned char *const *d
+ ,const unsigned int *l
+ ,unsigned char *h
+){
+  rmd320xn(rmd320iv, 0, d, l, h, 16);
+}
+
+void
+rmd320n(
+  unsigned int n
+ ,const unsigned char *const *d
+ ,const unsigned int *l
+ ,unsigned char *h
+){
+  unsigned int g;
+
+  for (; n; n -= g, d += g, l += g, h += g * RMD320_SZ) {
+    g = n < 16 ? n : 16;
+    rmd320xn(rmd320iv, 0, d, l, h, g);
+  }
+}
+
+/*
+ * One call over a message already in memory: whole blocks are compressed
+ * straight from it and only the tail is padded, in one or two blocks on
+ * the stack, with no context.
+ */
+static void
+rmd320fix(
+  const unsigned char *d
+ ,size_t l
+ ,unsigned char *h
+){
+  unsigned char b[128];
+  rmd320_bt s[10];
+  size_t k;
+  unsigned int t;
+  unsigned int n;
+  unsigned int i;
+
+#ifdef RMD320_DISPATCH
+  if (!rmd320mix)
+    rmd320auto();
+#endif
+  for (i = 0; i < 10; ++i)
+    s[i] = rmd320iv[i];
+  if ((k = l & ~(size_t)63)) {
+    rmd320mix(s, d, k / 64);
+    d += k;
+  }
+  t = (unsigned int)(l - k);
+  n = t < 64 - 8 ? 64 : 128;
+  for (i = 0; i < t; ++i)
+    b[i] = d[i];
+  b[i++] = 0x80;
+  for (; i < n - 8; ++i)
+    b[i] = 0x00;
+  rmd320len(b + n - 8, (rmd320_bt)(l >> 16 >> 16), (rmd320_bt)l);
+  rmd320mix(s, b, n / 64);
+  for (i = 0; i < 10; ++i) {
+    *h++ = (unsigned char)(s[i] >> (0 * 8));
+    *h++ = (unsigned char)(s[i] >> (1 * 8));
+    *h++ = (unsigned char)(s[i] >> (2 * 8));
+    *h++ = (unsigned char)(s[i] >> (3 * 8));
+  }
+}
+
+void
+rmd320(
+  const unsigned char *d
+ ,size_t l
+ ,unsigned char *h
+){
+  rmd320fix(d, l, h);
+}
+
+/*
+ * The fixed lengths: the message over a zeroed block, the 0x80 and the
+ * bit length (little endian) stored as constants, and the n padded
+ * blocks compressed from the IV in one call.
+ */
+static void
+rmd320fixb(
+  const unsigned char *b
+ ,unsigned int n
+ ,unsigned char *h
+){
+  rmd320_bt s[10];
+  unsigned int i;
+
+#ifdef RMD320_DISPATCH
+  if (!rmd320mix)
+    rmd320auto();
+#endif
+  for (i = 0; i < 10; ++i)
+    s[i] = rmd320iv[i];
+  rmd320mix(s, b, n);
+  for (i = 0; i < 10; ++i) {
+    *h++ = (unsigned char)(s[i] >> (0 * 8));
+    *h++ = (unsigned char)(s[i] >> (1 * 8));
+    *h++ = (unsigned char)(s[i] >> (2 * 8));
+    *h++ = (unsigned char)(s[i] >> (3 * 8));
+  }
+}
+
+void
+rmd320fix20(
+  const unsigned char *d
+ ,unsigned char *h
+){
+  unsigned char b[64] = { 0 };
+  unsigned int i;
+
+  for (i = 0; i < 20; ++i)
+    b[i] = d[i];
+  b[20] = 0x80;
+  b[56] = (unsigned char)(20 * 8); /* bit length */
+  b[57] = 20 * 8 >> 8;
+  rmd320fixb(b, 1, h);
+}
+
+void
+rmd320fix32(
+  const unsigned char *d
+ ,unsigned char *h
+){
+  unsigned char b[64] = { 0 };
+  unsigned int i;
+
+  for (i = 0; i < 32; ++i)
+    b[i] = d[i];
+  b[32] = 0x80;
+  b[56] = (unsigned char)(32 * 8); /* bit length */
+  b[57] = 32 * 8 >> 8;
+  rmd320fixb(b, 1, h);
+}
+
+void
+rmd320fix33(
+  const unsigned char *d
+ ,unsigned char *h
+){
+  unsigned char b[64] = { 0 };
+  unsigned int i;
+
+  for (i = 0; i < 33; ++i)
+    b[i] = d[i];
+  b[33] = 0x80;
+  b[56] = (unsigned char)(33 * 8); /* bit length */
+  b[57] = 33 * 8 >> 8;
+  rmd320fixb(b, 1, h);
+}
+
+void
+rmd320fix65(
+  const unsigned char *d
+ ,unsigned char *h
+){
+  unsigned char b[128] = { 0 };
+  unsigned int i;
+
+  for (i = 0; i < 65; ++i)
+    b[i] = d[i];
+  b[65] = 0x80;
+  b[120] = (unsigned char)(65 * 8); /* bit length */
+  b[121] = 65 * 8 >> 8;
+  rmd320fixb(b, 2, h);
+}
+
+/* n messages of l bytes laid end to end, through the batch lanes */
+void
+rmd320fixn(
+  unsigned int n
+ ,unsigned int l
+ ,const unsigned char *d
+ ,unsigned char *h
+){
+  const unsigned char *q[16];
+  unsigned int ql[16];
+  unsigned int g;
+  unsigned int i;
+
+  for (; n; n -= g, h += g * RMD320_SZ) {
+    g = n < 16 ? n : 16;
+    for (i = 0; i < g; ++i, d += l) {
+      q[i] = d;
+      ql[i] = l;
+    }
+    rmd320xn(rmd320iv, 0, q, ql, h, g);
+  }
+}
+
+struct rmd320pfx {
+  rmd320_t c;           /* after the prefix */
+};
+
+unsigned int
+rmd320pfxtsize(
+  void
+){
+  return (sizeof (rmd320pfx_t));
+}
+
+void
+rmd320pfxinit(
+  rmd320pfx_t *v
+ ,const unsigned char *p
+ ,size_t pl
+){
+  rmd320init(&v->c);
+  rmd320updatez(&v->c, p, pl);
+}
+
+void
+rmd320pfxstart(
+  const rmd320pfx_t *v
+ ,rmd320_t *c
+){
+  *c = v->c;
+}
+
+void
+rmd320pfx(
+  const rmd320pfx_t *v
+ ,const unsigned char *d
+ ,size_t dl
+ ,unsigned char *h
+){
+  rmd320_t c;
+
+  c = v->c;
+  rmd320updatez(&c, d, dl);
+  rmd320final(&c, h);
+}
+
+void
+rmd320pfxn(
+  const rmd320pfx_t *v
+ ,unsigned int n
+ ,const unsigned char *const *d
+ ,const unsigned int *dl
+ ,unsigned char *h
+){
+  unsigned int g;
+
+  if (v->c.l || v->c.bh) { /* the lanes start on a block boundary, under 4 GiB in */
+    for (; n; --n, ++d, ++dl, h += RMD320_SZ)
+      rmd320pfx(v, *d, *dl, h);
+    return;
+  }
+  for (; n; n -= g, d += g, dl += g, h += g * RMD320_SZ) {
+    g = n < 16 ? n : 16;
+    rmd320xn(v->c.h, v->c.bl, d, dl, h, g);
+  }
+}
+
+struct rmd320hkey {
+  rmd320_bt i[10];      /* chaining value after the ipad block */
+  rmd320_bt o[10];      /* chaining value after the opad block */
+};
+
+unsigned int
+rmd320hkeytsize(
+  void
+){
+  return (sizeof (rmd320hkey_t));
+}
+
+static void
+rmd320hkeyz(
+  rmd320hkey_t *v
+ ,const unsigned char *k
+ ,size_t kl
+){
+  rmd320_t c;
+  unsigned char p[64];
   unsigned char t[RMD320_SZ];
-  unsigned char t2[RMD320_SZ];
   unsigned int l;
-  unsigned int n;
 
-  if (sl > 255 * RMD320_SZ)
-    sl = 255 * RMD320_SZ;
   if (kl > 64) {
     rmd320init(&c);
-    rmd320update(&c, k, kl);
+    rmd320updatez(&c, k, kl);
     rmd320final(&c, t);
     k = t;
     kl = RMD320_SZ;
   }
-  for (l = 0; l < kl; ++l) {
-    i[l] = *(k + l) ^ 0x36;
-    o[l] = *(k + l) ^ 0x5c;
-  }
-  for (; l < 64; ++l) {
-    i[l] = 0x00 ^ 0x36;
-    o[l] = 0x00 ^ 0x5c;
+  for (l = 0; l < kl; ++l)
+    p[l] = *(k + l) ^ 0x36;
+  for (; l < 64; ++l)
+    p[l] = 0x00 ^ 0x36;
+  rmd320init(&c);
+  rmd320mix(c.h, p, 1);
+  for (l = 0; l < 10; ++l)
+    v->i[l] = c.h[l];
+  for (l = 0; l < 64; ++l)
+    p[l] ^= 0x36 ^ 0x5c;
+  rmd320init(&c);
+  rmd320mix(c.h, p, 1);
+  for (l = 0; l < 10; ++l)
+    v->o[l] = c.h[l];
+  rmd320wipe(&c, sizeof (c));
+  rmd320wipe(p, sizeof (p));
+  rmd320wipe(t, sizeof (t));
+}
+
+void
+rmd320hkeyinit(
+  rmd320hkey_t *v
+ ,const unsigned char *k
+ ,unsigned int kl
+){
+  rmd320hkeyz(v, k, kl);
+}
+
+struct rmd320hmac {
+  rmd320_t c;           /* inner hash */
+  rmd320_bt o[10];      /* chaining value after the opad block */
+};
+
+unsigned int
+rmd320hmactsize(
+  void
+){
+  return (sizeof (rmd320hmac_t));
+}
+
+void
+rmd320hmacstart(
+  rmd320hmac_t *v
+ ,const rmd320hkey_t *k
+){
+  unsigned int i;
+
+  rmd320resume(&v->c, k->i, 64);
+  for (i = 0; i < 10; ++i)
+    v->o[i] = k->o[i];
+}
+
+void
+rmd320hmacinit(
+  rmd320hmac_t *v
+ ,const unsigned char *k
+ ,unsigned int kl
+){
+  rmd320hkey_t s;
+
+  rmd320hkeyz(&s, k, kl);
+  rmd320hmacstart(v, &s);
+  rmd320wipe(&s, sizeof (s));
+}
+
+void
+rmd320hmacupdatez(
+  rmd320hmac_t *v
+ ,const unsigned char *d
+ ,size_t l
+){
+  rmd320updatez(&v->c, d, l);
+}
+
+void
+rmd320hmacupdate(
+  rmd320hmac_t *v
+ ,const unsigned char *d
+ ,unsigned int l
+){
+  rmd320updatez(&v->c, d, l);
+}
+
+void
+rmd320hmacfinal(
+  rmd320hmac_t *v
+ ,unsigned char *h
+){
+  rmd320final(&v->c, h);
+  rmd320resume(&v->c, v->o, 64);
+  rmd320update(&v->c, h, RMD320_SZ);
+  rmd320final(&v->c, h);
+  rmd320wipe(v, sizeof (*v));
+}
+
+void
+rmd320hkeymacz(
+  const rmd320hkey_t *v
+ ,const unsigned char *d
+ ,size_t dl
+ ,unsigned char *h
+){
+  rmd320hmac_t c;
+
+  rmd320hmacstart(&c, v);
+  rmd320hmacupdatez(&c, d, dl);
+  rmd320hmacfinal(&c, h);
+}
+
+void
+rmd320hkeymac(
+  const rmd320hkey_t *v
+ ,const unsigned char *d
+ ,unsigned int dl
+ ,unsigned char *h
+){
+  rmd320hkeymacz(v, d, dl, h);
+}
+
+/* n messages under one key schedule, run through the batch lanes */
+void
+rmd320hkeymacn(
+  const rmd320hkey_t *v
+ ,unsigned int n
+ ,const unsigned char *const *d
+ ,const unsigned int *dl
+ ,unsigned char *h
+){
+  unsigned char t[16][RMD320_SZ];  /* inner hash of each lane */
+  const unsigned char *q[16];
+  unsigned int ql[16];
+  unsigned int g;
+  unsigned int i;
+
+  for (; n; n -= g, d += g, dl += g, h += g * RMD320_SZ) {
+    g = n < 16 ? n : 16;
+    rmd320xn(v->i, 64, d, dl, t[0], g);
+    for (i = 0; i < g; ++i) {
+      q[i] = t[i];
+      ql[i] = RMD320_SZ;
+    }
+    rmd320xn(v->o, 64, q, ql, h, g);
   }
+  rmd320wipe(t, sizeof (t));
+}
+
+void
+rmd320hmacz(
+  const unsigned char *k
+ ,size_t kl
+ ,const unsigned char *d
+ ,size_t dl
+ ,unsigned char *h
+){
+  rmd320hkey_t v;
+
+  rmd320hkeyz(&v, k, kl);
+  rmd320hkeymacz(&v, d, dl, h);
+  rmd320wipe(&v, sizeof (v));
+}
+
+void
+rmd320hmac(
+  const unsigned char *k
+ ,unsigned int kl
+ ,const unsigned char *d
+ ,unsigned int dl
+ ,unsigned char *h
+){
+  rmd320hmacz(k, kl, d, dl, h);
+}
+
+/* HKDF-Expand from a key schedule of the PRK: each T(n) starts from its midstates */
+void
+rmd320hkeyhkdfz(
+  const rmd320hkey_t *v
+ ,const unsigned char *d
+ ,size_t dl
+ ,unsigned char *s
+ ,unsigned int sl
+){
+  rmd320hmac_t c;
+  unsigned char t[RMD320_SZ];
+  unsigned int l;
+  unsigned int n;
+
+  if (sl > 255 * RMD320_SZ)
+    sl = 255 * RMD320_SZ;
   for (n = 0, l = 0; l < sl;) {
     unsigned char b;
     unsigned int j;
 
     b = (unsigned char)++n;
-    rmd320init(&c);
-    rmd320update(&c, i, sizeof (i));
+    rmd320hmacstart(&c, v);
     if (n > 1)
-      rmd320update(&c, t, RMD320_SZ);
-    rmd320update(&c, d, dl);
-    rmd320update(&c, &b, 1);
-    rmd320final(&c, t2);
-    rmd320init(&c);
-    rmd320update(&c, o, sizeof (o));
-    rmd320update(&c, t2, RMD320_SZ);
-    rmd320final(&c, t);
+      rmd320hmacupdate(&c, t, RMD320_SZ);
+    rmd320hmacupdatez(&c, d, dl);
+    rmd320hmacupdate(&c, &b, 1);
+    rmd320hmacfinal(&c, t);
     for (j = 0; j < RMD320_SZ && l < sl; ++j, ++l)
       s[l] = t[j];
   }
-  /* wipe stack residue once; volatile defeats dead-store elimination */
-  {
-    volatile unsigned char *p;
-    unsigned int m;
+  rmd320wipe(t, sizeof (t));
+}
+
+void
+rmd320hkeyhkdf(
+  const rmd320hkey_t *v
+ ,const unsigned char *d
+ ,unsigned int dl
+ ,unsigned char *s
+ ,unsigned int sl
+){
+  rmd320hkeyhkdfz(v, d, dl, s, sl);
+}
 
-    p = (volatile unsigned char *)&c;
-    for (m = 0; m < sizeof (c); ++m)
-      *p++ = 0;
-    p = (volatile unsigned char *)i;
-    for (m = 0; m < sizeof (i); ++m)
-      *p++ = 0;
-    p = (volatile unsigned char *)o;
-    for (m = 0; m < sizeof (o); ++m)
-      *p++ = 0;
-    p = (volatile unsigned char *)t;
-    for (m = 0; m < sizeof (t); ++m)
-      *p++ = 0;
-    p = (volatile unsigned char *)t2;
-    for (m = 0; m < sizeof (t2); ++m)
-      *p++ = 0;
+/* HKDF-Expand of n infos under one key schedule, ol bytes into each o[i] */
+void
+rmd320hkeyhkdfn(
+  const rmd320hkey_t *v
+ ,unsigned int n
+ ,const unsigned char *const *d
+ ,const unsigned int *dl
+ ,unsigned char *const *o
+ ,unsigned int ol
+){
+  unsigned char m[16][128];        /* T(n-1) | info | counter of each lane */
+  unsigned char t[16][RMD320_SZ];  /* inner hash of each lane */
+  unsigned char u[16][RMD320_SZ];  /* T(n) of each lane */
+  const unsigned char *q[16];
+  unsigned int ql[16];
+  unsigned int x[16];              /* info of each lane */
+  unsigned int g;
+  unsigned int i;
+  unsigned int j;
+  unsigned int k;
+  unsigned int l;
+  unsigned char b;
+
+  if (ol > 255 * RMD320_SZ)
+    ol = 255 * RMD320_SZ;
+  for (i = 0; i < n;) {
+    for (g = 0; g < 16 && i < n; ++i)
+      if (dl[i] < sizeof (m[0]) - RMD320_SZ)
+        x[g++] = i;
+      else /* too long to stage in a lane */
+        rmd320hkeyhkdf(v, d[i], dl[i], o[i], ol);
+    for (b = 1, l = 0; l < ol; ++b, l += RMD320_SZ) {
+      for (j = 0; j < g; ++j) {
+        unsigned char *s;
+
+        s = m[j];
+        if (b > 1)
+          for (k = 0; k < RMD320_SZ; ++k)
+            *s++ = u[j][k];
+        for (k = 0; k < dl[x[j]]; ++k)
+          *s++ = d[x[j]][k];
+        *s++ = b;
+        q[j] = m[j];
+        ql[j] = (unsigned int)(s - m[j]);
+      }
+      rmd320xn(v->i, 64, q, ql, t[0], g);
+      for (j = 0; j < g; ++j) {
+        q[j] = t[j];
+        ql[j] = RMD320_SZ;
+      }
+      rmd320xn(v->o, 64, q, ql, u[0], g);
+      for (j = 0; j < g; ++j)
+        for (k = 0; k < RMD320_SZ && l + k < ol; ++k)
+          o[x[j]][l + k] = u[j][k];
+    }
   }
+  rmd320wipe(m, sizeof (m));
+  rmd320wipe(t, sizeof (t));
+  rmd320wipe(u, sizeof (u));
 }
 
 void
-rmd320hex(
-  const unsigned char *h
- ,char *o
+rmd320hkdfextract(
+  const unsigned char *s
+ ,unsigned int sl
+ ,const unsigned char *k
+ ,unsigned int kl
+ ,unsigned char *h
 ){
+  rmd320hmac(s, sl, k, kl, h);
+}
+
+void
+rmd320hkdfz(
+  const unsigned char *k
+ ,size_t kl
+ ,const unsigned char *d
+ ,size_t dl
+ ,unsigned char *s
+ ,unsigned int sl
+){
+  rmd320hkey_t v;
+
+  rmd320hkeyz(&v, k, kl);
+  rmd320hkeyhkdfz(&v, d, dl, s, sl);
+  rmd320wipe(&v, sizeof (v));
+}
+
+void
+rmd320hkdf(
+  const unsigned char *k
+ ,unsigned int kl
+ ,const unsigned char *d
+ ,unsigned int dl
+ ,unsigned char *s
+ ,unsigned int sl
+){
+  rmd320hkdfz(k, kl, d, dl, s, sl);
+}
+
+/*
+ * Tree hash: the input is cut into RMD320_CHUNK byte chunks (the last one
+ * shorter, an empty input one empty chunk) and
+ *  leaf = RIPEMD-320(L | chunk)
+ *  node = RIPEMD-320(N | left | right)
+ * where L is a 64 byte block of 0x00 and N is 0x01 followed by 63 0x00.
+ * Leaves are paired left to right a level at a time, an odd node at the end
+ * of a level moves up unpaired, until one node, the root, remains.
+ * The prefixes fill a block so every leaf and node starts from a cached
+ * midstate and the chunks stay block aligned for the batch lanes.
+ */
+
+struct rmd320tree {
+  rmd320_t c;           /* current leaf */
+  rmd320_bt m[10];      /* chaining value after L */
+  size_t n;             /* leaves done */
+  size_t f;             /* bytes in the current leaf */
+  unsigned int d;       /* subtrees on the stack */
+  unsigned char s[sizeof (size_t) * 8][RMD320_SZ]; /* complete subtrees, largest first */
+};
+
+unsigned int
+rmd320treetsize(
+  void
+){
+  return (sizeof (rmd320tree_t));
+}
+
+/* chaining value after the prefix block of a leaf (0x00) or node (0x01) */
+static void
+rmd320treemid(
+  rmd320_bt s[]
+ ,unsigned char b
+){
+  rmd320_t c;
+  unsigned char p[64];
   unsigned int i;
 
-  for (i = 0; i < RMD320_SZ; ++i, ++h) {
-    static const char m[] = "0123456789abcdef";
+  p[0] = b;
+  for (i = 1; i < 64; ++i)
+    p[i] = 0x00;
+  rmd320init(&c);
+  rmd320mix(c.h, p, 1);
+  for (i = 0; i < 10; ++i)
+    s[i] = c.h[i];
+}
 
+void
+rmd320treeleafn(
+  unsigned int n
+ ,const unsigned char *const *d
+ ,const unsigned int *l
+ ,unsigned char *h
+){
+  rmd320_bt s[10];
+
+  rmd320treemid(s, 0x00);
+  rmd320xn(s, 64, d, l, h, n);
+}
+
+/* n adjacent (left, right) pairs, through the batch lanes */
+void
+rmd320treenoden(
+  unsigned int n
+ ,const unsigned char *p
+ ,unsigned char *h
+){
+  rmd320_bt s[10];
+  const unsigned char *q[16];
+  unsigned int ql[16];
+  unsigned int g;
+  unsigned int j;
+
+  rmd320treemid(s, 0x01);
+  for (; n; n -= g, p += g * 2 * RMD320_SZ, h += g * RMD320_SZ) {
+    g = n < 16 ? n : 16;
+    for (j = 0; j < g; ++j) {
+      q[j] = p + j * 2 * RMD320_SZ;
+      ql[j] = 2 * RMD320_SZ;
+    }
+    rmd320xn(s, 64, q, ql, h, g);
+  }
+}
+
+void
+rmd320treenode(
+  const unsigned char *l
+ ,const unsigned char *r
+ ,unsigned char *h
+){
+  unsigned char t[2 * RMD320_SZ];
+  unsigned int i;
+
+  for (i = 0; i < RMD320_SZ; ++i) {
+    t[i] = l[i];
+    t[RMD320_SZ + i] = r[i];
+  }
+  rmd320treenoden(1, t, h);
+}
+
+void
+rmd320treeroot(
+  unsigned char *a
+ ,size_t n
+ ,unsigned char *h
+){
+  unsigned char t[16][RMD320_SZ];
+  const unsigned char *q;
+  unsigned int ql;
+  size_t m;
+  size_t i;
+  unsigned int g;
+  unsigned int j;
+  unsigned int k;
+
+  if (!n) { /* no chunks is one empty leaf */
+    q = a;
+    ql = 0;
+    rmd320treeleafn(1, &q, &ql, h);
+    return;
+  }
+  for (; n > 1; n = m + (n & 1)) {
+    m = n / 2;
+    for (i = 0; i < m; i += g) {
+      g = m - i < 16 ? (unsigned int)(m - i) : 16;
+      rmd320treenoden(g, a + i * 2 * RMD320_SZ, t[0]);
+      for (j = 0; j < g; ++j) /* behind every pair still to be read */
+        for (k = 0; k < RMD320_SZ; ++k)
+          a[(i + j) * RMD320_SZ + k] = t[j][k];
+    }
+    if (n & 1)
+      for (j = 0; j < RMD320_SZ; ++j)
+        a[m * RMD320_SZ + j] = a[(n - 1) * RMD320_SZ + j];
+  }
+  for (j = 0; j < RMD320_SZ; ++j)
+    h[j] = a[j];
+}
+
+void
+rmd320treeinit(
+  rmd320tree_t *v
+){
+  rmd320treemid(v->m, 0x00);
+  rmd320resume(&v->c, v->m, 64);
+  v->n = v->f = 0;
+  v->d = 0;
+}
+
+/* add a leaf, merging the equal sized subtrees it completes */
+static void
+rmd320treepush(
+  rmd320tree_t *v
+ ,const unsigned char *h
+){
+  size_t m;
+  unsigned int i;
+
+  for (i = 0; i < RMD320_SZ; ++i)
+    v->s[v->d][i] = h[i];
+  ++v->d;
+  for (m = ++v->n; !(m & 1); m >>= 1, --v->d)
+    rmd320treenode(v->s[v->d - 2], v->s[v->d - 1], v->s[v->d - 2]);
+}
+
+void
+rmd320treeupdate(
+  rmd320tree_t *v
+ ,const unsigned char *d
+ ,size_t l
+){
+  unsigned char t[16][RMD320_SZ];
+  const unsigned char *q[16];
+  unsigned int ql[16];
+  size_t k;
+  unsigned int g;
+  unsigned int i;
+
+  while (l) {
+    if (!v->f && l >= RMD320_CHUNK) { /* whole chunks through the batch lanes */
+      for (g = 0; g < 16 && l >= RMD320_CHUNK; ++g, d += RMD320_CHUNK, l -= RMD320_CHUNK) {
+        q[g] = d;
+        ql[g] = RMD320_CHUNK;
+      }
+      rmd320treeleafn(g, q, ql, t[0]);
+      for (i = 0; i < g; ++i)
+        rmd320treepush(v, t[i]);
+      continue;
+    }
+    k = RMD320_CHUNK - v->f < l ? RMD320_CHUNK - v->f : l;
+    rmd320updatez(&v->c, d, k);
+    v->f += k;
+    d += k;
+    l -= k;
+    if (v->f == RMD320_CHUNK) {
+      rmd320final(&v->c, t[0]);
+      rmd320treepush(v, t[0]);
+      rmd320resume(&v->c, v->m, 64);
+      v->f = 0;
+    }
+  }
+}
+
+void
+rmd320treefinal(
+  rmd320tree_t *v
+ ,unsigned char *h
+){
+  unsigned int i;
+
+  if (v->f || !v->n) {
+    rmd320final(&v->c, h);
+    rmd320treepush(v, h);
+  }
+  for (; v->d > 1; --v->d)
+    rmd320treenode(v->s[v->d - 2], v->s[v->d - 1], v->s[v->d - 2]);
+  for (i = 0; i < RMD320_SZ; ++i)
+    h[i] = v->s[0][i];
+}
+
+void
+rmd320tree(
+  const unsigned char *d
+ ,size_t l
+ ,unsigned char *h
+){
+  rmd320tree_t v;
+
+  rmd320treeinit(&v);
+  rmd320treeupdate(&v, d, l);
+  rmd320treefinal(&v, h);
+}
+
+/* n bytes to 2 * n hex characters */
+static void
+rmd320hexs(
+  const unsigned char *h
+ ,char *o
+ ,unsigned int n
+){
+  static const char m[] = "0123456789abcdef";
+
+  for (; n; --n, ++h) {
     *o++ = m[(*h >> 4) & 0xf];
     *o++ = m[(*h >> 0) & 0xf];
   }
 }
+
+/* 2 * n hex characters (either case) to n bytes: -1, else the offset of the first bad one */
+static int
+rmd320unhexs(
+  const char *s
+ ,unsigned char *h
+ ,unsigned int n
+){
+  unsigned int i;
+  unsigned int v;
+  int c;
+
+  for (i = 0, v = 0; i < 2 * n; ++i) {
+    c = (unsigned char)s[i];
+    if (c >= '0' && c <= '9')
+      c -= '0';
+    else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+      c = (c | 0x20) - 'a' + 10;
+    else
+      return ((int)i);
+    v = v << 4 | (unsigned int)c;
+    if (i & 1)
+      *h++ = (unsigned char)v;
+  }
+  return (-1);
+}
+
+#ifdef RMD320_AVX2
+/*
+ * Sixteen bytes at a time: the nibbles index a table of the hex digits
+ * (pshufb), and sixteen characters at a time are range checked, turned to
+ * nibbles and paired (pmaddubsw) back into bytes.
+ * Digests are 20 or 40 bytes, so 128 bit registers carry the work
+ * and the odd tail goes through the scalar loops.
+ */
+RMD320_AVX2
+static void
+rmd320hexv(
+  const unsigned char *h
+ ,char *o
+){
+  const __m128i t = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+  const __m128i m = _mm_set1_epi8(0x0f);
+  __m128i b;
+  __m128i u;
+  __m128i l;
+  unsigned int i;
+
+  for (i = 0; i + 16 <= RMD320_SZ; i += 16) {
+    b = _mm_loadu_si128((const __m128i *)(h + i));
+    u = _mm_shuffle_epi8(t, _mm_and_si128(_mm_srli_epi16(b, 4), m));
+    l = _mm_shuffle_epi8(t, _mm_and_si128(b, m));
+    _mm_storeu_si128((__m128i *)(o + 2 * i), _mm_unpacklo_epi8(u, l));
+    _mm_storeu_si128((__m128i *)(o + 2 * i + 16), _mm_unpackhi_epi8(u, l));
+  }
+  rmd320hexs(h + i, o + 2 * i, RMD320_SZ - i);
+}
+
+RMD320_AVX2
+static int
+rmd320unhexv(
+  const char *s
+ ,unsigned char *h
+){
+  __m128i c;
+  __m128i w;
+  __m128i d;
+  __m128i a;
+  unsigned int k;
+  unsigned int i;
+  int r;
+
+  for (i = 0; i + 16 <= 2 * RMD320_SZ; i += 16) {
+    c = _mm_loadu_si128((const __m128i *)(s + i));
+    w = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    d = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    a = _mm_and_si128(_mm_cmpgt_epi8(w, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(w, _mm_set1_epi8('f' + 1)));
+    if ((k = (unsigned int)_mm_movemask_epi8(_mm_or_si128(d, a))) != 0xffff)
+      return ((int)(i + (unsigned int)__builtin_ctz(~k)));
+    c = _mm_blendv_epi8(_mm_sub_epi8(w, _mm_set1_epi8('a' - 10)), _mm_sub_epi8(c, _mm_set1_epi8('0')), d);
+    c = _mm_maddubs_epi16(c, _mm_set1_epi16(0x0110));
+    _mm_storel_epi64((__m128i *)(h + i / 2), _mm_packus_epi16(c, c));
+  }
+  if ((r = rmd320unhexs(s + i, h + i / 2, RMD320_SZ - i / 2)) >= 0)
+    r += (int)i;
+  return (r);
+}
+#endif /* RMD320_AVX2 */
+
+void
+rmd320hex(
+  const unsigned char *h
+ ,char *o
+){
+#ifdef RMD320_DISPATCH
+  if (!rmd320mix)
+    rmd320auto();
+#endif
+#ifdef RMD320_AVX2
+  if (RMD320_HEXV) {
+    rmd320hexv(h, o);
+    return;
+  }
+#endif
+  rmd320hexs(h, o, RMD320_SZ);
+}
+
+int
+rmd320unhex(
+  const char *s
+ ,unsigned char *h
+){
+#ifdef RMD320_DISPATCH
+  if (!rmd320mix)
+    rmd320auto();
+#endif
+#ifdef RMD320_AVX2
+  if (RMD320_HEXV)
+    return (rmd320unhexv(s, h));
+#endif
+  return (rmd320unhexs(s, h, RMD320_SZ));
+}
+
+void
+rmd320hexn(
+  unsigned int n
+ ,const unsigned char *h
+ ,char *o
+ ,unsigned int os
+){
+  for (; n; --n, h += RMD320_SZ, o += os)
+    rmd320hex(h, o);
+}
+
+unsigned int
+rmd320unhexn(
+  unsigned int n
+ ,const char *s
+ ,unsigned int ss
+ ,unsigned char *h
+){
+  unsigned int i;
+
+  for (i = 0; i < n; ++i, s += ss, h += RMD320_SZ)
+    if (rmd320unhex(s, h) >= 0)
+      break;
+  return (i);
+}
@@ -21,14 +21,70 @@
 #ifndef RMD320_H
 #define RMD320_H
 
+#include <stddef.h>
+
 #define RMD320_SZ 40
 typedef struct rmd320 rmd320_t;
 unsigned int rmd320tsize(void);
 void rmd320init(rmd320_t *);
 void rmd320update(rmd320_t *, const unsigned char *, unsigned int);
+void rmd320updatez(rmd320_t *, const unsigned char *, size_t); /* no 4 GiB limit on the length */
 void rmd320final(rmd320_t *, unsigned char *); /* RMD320_SZ */
+void rmd320copy(rmd320_t *, const rmd320_t *); /* a copy of a context mid stream, to hash on from */
+#define RMD320_STATESZ 120 /* exported state, the same bytes on any machine */
+void rmd320export(const rmd320_t *, unsigned char *s); /* RMD320_STATESZ, before rmd320final */
+int rmd320import(rmd320_t *, const unsigned char *s, unsigned long long *n); /* from rmd320export, n (if not 0) the bytes hashed so far; 0, else -1 if s is not one */
+void rmd320x16(const unsigned char *const *d, const unsigned int *l, unsigned char *h); /* 16 messages, 16 * RMD320_SZ */
+void rmd320n(unsigned int n, const unsigned char *const *d, const unsigned int *l, unsigned char *h); /* n messages through the batch lanes, n * RMD320_SZ */
+void rmd320(const unsigned char *d, size_t l, unsigned char *h); /* one call, no context, RMD320_SZ */
+void rmd320fix20(const unsigned char *d, unsigned char *h); /* 20 byte message, RMD320_SZ */
+void rmd320fix32(const unsigned char *d, unsigned char *h); /* 32 byte message, RMD320_SZ */
+void rmd320fix33(const unsigned char *d, unsigned char *h); /* 33 byte message, RMD320_SZ */
+void rmd320fix65(const unsigned char *d, unsigned char *h); /* 65 byte message, RMD320_SZ */
+void rmd320fixn(unsigned int n, unsigned int l, const unsigned char *d, unsigned char *h); /* n messages of l bytes end to end, n * RMD320_SZ */
+typedef struct rmd320pfx rmd320pfx_t; /* a constant prefix, hashed once */
+unsigned int rmd320pfxtsize(void);
+void rmd320pfxinit(rmd320pfx_t *, const unsigned char *p, size_t pl);
+void rmd320pfxstart(const rmd320pfx_t *, rmd320_t *); /* a context that has hashed the prefix */
+void rmd320pfx(const rmd320pfx_t *, const unsigned char *d, size_t dl, unsigned char *h); /* RIPEMD-320(prefix | d), RMD320_SZ */
+void rmd320pfxn(const rmd320pfx_t *, unsigned int n, const unsigned char *const *d, const unsigned int *dl, unsigned char *h); /* n messages, n * RMD320_SZ, through the batch lanes when the prefix is whole blocks */
+typedef struct rmd320hkey rmd320hkey_t; /* HMAC key schedule: keyed inner and outer midstates */
+unsigned int rmd320hkeytsize(void);
+void rmd320hkeyinit(rmd320hkey_t *, const unsigned char *k, unsigned int kl);
+void rmd320hkeymac(const rmd320hkey_t *, const unsigned char *d, unsigned int dl, unsigned char *h); /* RMD320_SZ */
+void rmd320hkeymacz(const rmd320hkey_t *, const unsigned char *d, size_t dl, unsigned char *h); /* RMD320_SZ */
+void rmd320hkeymacn(const rmd320hkey_t *, unsigned int n, const unsigned char *const *d, const unsigned int *dl, unsigned char *h); /* n messages, n * RMD320_SZ */
+typedef struct rmd320hmac rmd320hmac_t; /* streaming HMAC */
+unsigned int rmd320hmactsize(void);
+void rmd320hmacinit(rmd320hmac_t *, const unsigned char *k, unsigned int kl);
+void rmd320hmacstart(rmd320hmac_t *, const rmd320hkey_t *); /* init from a key schedule */
+void rmd320hmacupdate(rmd320hmac_t *, const unsigned char *, unsigned int);
+void rmd320hmacupdatez(rmd320hmac_t *, const unsigned char *, size_t);
+void rmd320hmacfinal(rmd320hmac_t *, unsigned char *); /* RMD320_SZ, wipes the context */
 void rmd320hmac(const unsigned char *k, unsigned int kl, const unsigned char *d, unsigned int dl, unsigned char *h); /* RMD320_SZ */
-void rmd320hkdf(const unsigned char *k, unsigned int kl, const unsigned char *d, unsigned int dl, unsigned char *o, unsigned int ol); /* up to 255 * RMD320_SZ */
+void rmd320hmacz(const unsigned char *k, size_t kl, const unsigned char *d, size_t dl, unsigned char *h); /* RMD320_SZ */
+void rmd320hkeyhkdf(const rmd320hkey_t *, const unsigned char *d, unsigned int dl, unsigned char *o, unsigned int ol); /* HKDF-Expand from the key schedule of a PRK, up to 255 * RMD320_SZ */
+void rmd320hkeyhkdfz(const rmd320hkey_t *, const unsigned char *d, size_t dl, unsigned char *o, unsigned int ol); /* up to 255 * RMD320_SZ */
+void rmd320hkeyhkdfn(const rmd320hkey_t *, unsigned int n, const unsigned char *const *d, const unsigned int *dl, unsigned char *const *o, unsigned int ol); /* n infos, ol up to 255 * RMD320_SZ into each o[] */
+void rmd320hkdfextract(const unsigned char *s, unsigned int sl, const unsigned char *k, unsigned int kl, unsigned char *h); /* salt, IKM, PRK of RMD320_SZ */
+void rmd320hkdf(const unsigned char *k, unsigned int kl, const unsigned char *d, unsigned int dl, unsigned char *o, unsigned int ol); /* HKDF-Expand, PRK k, info d, up to 255 * RMD320_SZ */
+void rmd320hkdfz(const unsigned char *k, size_t kl, const unsigned char *d, size_t dl, unsigned char *o, unsigned int ol); /* up to 255 * RMD320_SZ */
+#define RMD320_CHUNK (1024U * 1024U) /* tree hash leaf size */
+typedef struct rmd320tree rmd320tree_t; /* streaming tree hash */
+unsigned int rmd320treetsize(void);
+void rmd320treeinit(rmd320tree_t *);
+void rmd320treeupdate(rmd320tree_t *, const unsigned char *, size_t);
+void rmd320treefinal(rmd320tree_t *, unsigned char *); /* RMD320_SZ */
+void rmd320tree(const unsigned char *d, size_t l, unsigned char *h); /* RMD320_SZ */
+void rmd320treeleafn(unsigned int n, const unsigned char *const *d, const unsigned int *l, unsigned char *h); /* n chunks of up to RMD320_CHUNK, n * RMD320_SZ */
+void rmd320treenode(const unsigned char *l, const unsigned char *r, unsigned char *h); /* RMD320_SZ each */
+void rmd320treenoden(unsigned int n, const unsigned char *p, unsigned char *h); /* n adjacent (left, right) pairs of RMD320_SZ, n * RMD320_SZ */
+void rmd320treeroot(unsigned char *a, size_t n, unsigned char *h); /* n leaves of RMD320_SZ (overwritten), RMD320_SZ */
 void rmd320hex(const unsigned char *, char *); /* RMD320_SZ, 2 * RMD320_SZ (not null-terminated) */
+int rmd320unhex(const char *, unsigned char *); /* 2 * RMD320_SZ hex digits in either case, RMD320_SZ; -1, else the offset of the first that is not one */
+void rmd320hexn(unsigned int n, const unsigned char *h, char *o, unsigned int os); /* n digests end to end, each 2 * RMD320_SZ characters at o + i * os */
+unsigned int rmd320unhexn(unsigned int n, const char *s, unsigned int ss, unsigned char *h); /* n hex digests at s + i * ss, n * RMD320_SZ; n, else the index of the first malformed */
+int rmd320kernel(const char *); /* "loop", "unroll", "avx512" or 0 for fastest, -1 if not available */
+const char *rmd320kernelname(void); /* kernel in use */
 
 #endif /* RMD320_H */
@@ -0,0 +1,396 @@
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "rmd160.h"
+#include "rmd320.h"
+
+/*
+ * CSV on standard output, one row per primitive and message size:
+ *  primitive,kernel,lanes,bytes,calls,seconds,MB/s,cycles/byte,cycles/call,p50 ns,p99 ns,speedup
+ * bytes is the size of each lane's message, MB/s and cycles/byte count
+ * every lane, cycles are TSC ticks (empty where there is no TSC) and the
+ * per call latency percentiles are only taken for small messages.
+ * An optional argument caps the bytes a call hashes over all its lanes
+ * (default 16 MiB, the largest size 1 GiB), so the batch rows stop at a
+ * sixteenth of the single ones.
+ * The single stream rows repeat for every kernel the build can select
+ * (RMD160_DISPATCH / RMD320_DISPATCH, as make bench builds it), unroll
+ * first, and speedup is calls per second over those of the unroll row
+ * of the same primitive and size (empty where there is none).
+ */
+
+#define BUDGET 0.1     /* seconds of calls per throughput row */
+#define SMALL 4096     /* largest message with latency percentiles */
+#define SAMPLES 10000  /* timed calls per latency row */
+
+static rmd160_t *C160;
+static rmd320_t *C320;
+static rmd160hkey_t *K160;
+static rmd320hkey_t *K320;
+static rmd160pfx_t *P160;
+static rmd320pfx_t *P320;
+static const unsigned char *Lane[16];
+static unsigned int Len[16];
+static unsigned char Out[16 * 4 * RMD160_SZ];
+static unsigned char *Okm[16];
+
+static void
+b160(
+  const unsigned char *d
+ ,unsigned int l
+){
+  rmd160init(C160);
+  rmd160update(C160, d, l);
+  rmd160final(C160, Out);
+}
+
+static void
+b320(
+  const unsigned char *d
+ ,unsigned int l
+){
+  rmd320init(C320);
+  rmd320update(C320, d, l);
+  rmd320final(C320, Out);
+}
+
+static void
+b160one(
+  const unsigned char *d
+ ,unsigned int l
+){
+  rmd160(d, l, Out);
+}
+
+static void
+b320one(
+  const unsigned char *d
+ ,unsigned int l
+){
+  rmd320(d, l, Out);
+}
+
+/* tag | message, the 64 byte tag compressed once */
+static void
+b160pfx(
+  const unsigned char *d
+ ,unsigned int l
+){
+  rmd160pfx(P160, d, l, Out);
+}
+
+static void
+b320pfx(
+  const unsigned char *d
+ ,unsigned int l
+){
+  rmd320pfx(P320, d, l, Out);
+}
+
+static void
+b160pfxn(
+  const unsigned char *d
+ ,unsigned int l
+){
+  unsigned int i;
+
+  for (i = 0; i < 16; ++i) {
+    Lane[i] = d;
+    Len[i] = l;
+  }
+  rmd160pfxn(P160, 16, Lane, Len, Out);
+}
+
+static void
+b160hmac(
+  const unsigned char *d
+ ,unsigned int l
+){
+  rmd160hmac((const unsigned char *)"0123456789abcdef0123", RMD160_SZ, d, l, Out);
+}
+
+static void
+b320hmac(
+  const unsigned char *d
+ ,unsigned int l
+){
+  rmd320hmac((const unsigned char *)"0123456789abcdef0123456789abcdef01234567", RMD320_SZ, d, l, Out);
+}
+
+static void
+b160hkey(
+  const unsigned char *d
+ ,unsigned int l
+){
+  rmd160hkeymac(K160, d, l, Out);
+}
+
+static void
+b320hkey(
+  const unsigned char *d
+ ,unsigned int l
+){
+  rmd320hkeymac(K320, d, l, Out);
+}
+
+static void
+b160hkdf(
+  const unsigned char *d
+ ,unsigned int l
+){
+  rmd160hkdf((const unsigned char *)"0123456789abcdef0123", RMD160_SZ, d, l, Out, 4 * RMD160_SZ);
+}
+
+static void
+b160hkdfn(
+  const unsigned char *d
+ ,unsigned int l
+){
+  unsigned int i;
+
+  for (i = 0; i < 16; ++i) {
+    Lane[i] = d;
+    Len[i] = l;
+    Okm[i] = Out + i * 4 * RMD160_SZ;
+  }
+  rmd160hkeyhkdfn(K160, 16, Lane, Len, Okm, 4 * RMD160_SZ);
+}
+
+static void
+b160hkeyn(
+  const unsigned char *d
+ ,unsigned int l
+){
+  unsigned int i;
+
+  for (i = 0; i < 16; ++i) {
+    Lane[i] = d;
+    Len[i] = l;
+  }
+  rmd160hkeymacn(K160, 16, Lane, Len, Out);
+}
+
+static void
+b160x8(
+  const unsigned char *d
+ ,unsigned int l
+){
+  unsigned int i;
+
+  for (i = 0; i < 8; ++i) {
+    Lane[i] = d;
+    Len[i] = l;
+  }
+  rmd160x8(Lane, Len, Out);
+}
+
+static void
+b160x16(
+  const unsigned char *d
+ ,unsigned int l
+){
+  unsigned int i;
+
+  for (i = 0; i < 16; ++i) {
+    Lane[i] = d;
+    Len[i] = l;
+  }
+  rmd160x16(Lane, Len, Out);
+}
+
+static void
+b320x16(
+  const unsigned char *d
+ ,unsigned int l
+){
+  unsigned int i;
+
+  for (i = 0; i < 16; ++i) {
+    Lane[i] = d;
+    Len[i] = l;
+  }
+  rmd320x16(Lane, Len, Out);
+}
+
+static void
+b160tree(
+  const unsigned char *d
+ ,unsigned int l
+){
+  rmd160tree(d, l, Out);
+}
+
+static void
+b320tree(
+  const unsigned char *d
+ ,unsigned int l
+){
+  rmd320tree(d, l, Out);
+}
+
+static const struct prim {
+  const char *name;
+  void (*f)(const unsigned char *, unsigned int);
+  const char *(*k)(void);
+  unsigned int lanes;
+  int (*sel)(const char *); /* kernel select, for a row per kernel */
+} Prim[] = {
+  { "rmd160",      b160,      rmd160kernelname,  1, rmd160kernel }
+ ,{ "rmd320",      b320,      rmd320kernelname,  1, rmd320kernel }
+ ,{ "rmd160one",   b160one,   rmd160kernelname,  1, rmd160kernel }
+ ,{ "rmd320one",   b320one,   rmd320kernelname,  1, rmd320kernel }
+ ,{ "rmd160pfx",   b160pfx,   rmd160kernelname,  1, 0 }
+ ,{ "rmd320pfx",   b320pfx,   rmd320kernelname,  1, 0 }
+ ,{ "rmd160pfxn",  b160pfxn,  rmd160kernelname, 16, 0 }
+ ,{ "rmd160hmac",  b160hmac,  rmd160kernelname,  1, 0 }
+ ,{ "rmd320hmac",  b320hmac,  rmd320kernelname,  1, 0 }
+ ,{ "rmd160hkey",  b160hkey,  rmd160kernelname,  1, 0 }
+ ,{ "rmd320hkey",  b320hkey,  rmd320kernelname,  1, 0 }
+ ,{ "rmd160hkeyn", b160hkeyn, rmd160kernelname, 16, 0 }
+ ,{ "rmd160hkdf",  b160hkdf,  rmd160kernelname,  1, 0 }
+ ,{ "rmd160hkdfn", b160hkdfn, rmd160kernelname, 16, 0 }
+ ,{ "rmd160x8",    b160x8,    rmd160kernelname,  8, 0 }
+ ,{ "rmd160x16",   b160x16,   rmd160kernelname, 16, 0 }
+ ,{ "rmd320x16",   b320x16,   rmd320kernelname, 16, 0 }
+ ,{ "rmd160tree",  b160tree,  rmd160kernelname,  1, 0 }
+ ,{ "rmd320tree",  b320tree,  rmd320kernelname,  1, 0 }
+};
+
+static const char *const Kern[] = { "unroll", "loop", "avx2", "avx512" }; /* the baseline first */
+
+static const unsigned int Size[] = {
+  0, 1, 16, 20, 32, 55, 56, 64, 128, 256, 512, 1024, 4096
+ ,16384, 65536, 1U << 20, 16U << 20, 256U << 20, 1U << 30
+};
+
+static double
+now(
+  void
+){
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (t.tv_sec + t.tv_nsec / 1e9);
+}
+
+static unsigned long long
+ticks(
+  void
+){
+#if defined(__x86_64__) || defined(__i386__)
+  return (__rdtsc());
+#else
+  return (0);
+#endif
+}
+
+static int
+cmp(
+  const void *a
+ ,const void *b
+){
+  return (*(const double *)a > *(const double *)b) - (*(const double *)a < *(const double *)b);
+}
+
+int
+main(
+  int argc
+ ,char *argv[]
+){
+  static double lat[SAMPLES];
+  double base[sizeof (Size) / sizeof (Size[0])];
+  unsigned char *m;
+  const char *kn;
+  unsigned long long c;
+  unsigned long n;
+  unsigned long i;
+  unsigned int max;
+  unsigned int p;
+  unsigned int k;
+  unsigned int s;
+  double t;
+  double b;
+  double r;
+
+  max = argc > 1 ? (unsigned int)strtoul(argv[1], 0, 0) : 16U << 20;
+  if (!(C160 = malloc(rmd160tsize()))
+   || !(C320 = malloc(rmd320tsize()))
+   || !(K160 = malloc(rmd160hkeytsize()))
+   || !(K320 = malloc(rmd320hkeytsize()))
+   || !(P160 = malloc(rmd160pfxtsize()))
+   || !(P320 = malloc(rmd320pfxtsize()))
+   || !(m = malloc(max ? max : 1))) {
+    fprintf(stderr, "malloc failed\n");
+    return (1);
+  }
+  rmd160hkeyinit(K160, (const unsigned char *)"0123456789abcdef0123", RMD160_SZ);
+  rmd320hkeyinit(K320, (const unsigned char *)"0123456789abcdef0123456789abcdef01234567", RMD320_SZ);
+  rmd160pfxinit(P160, (const unsigned char *)"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef", 64);
+  rmd320pfxinit(P320, (const unsigned char *)"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef", 64);
+  for (i = 0; i < max; ++i)
+    m[i] = (unsigned char)(i * 131 + 7);
+  printf("primitive,kernel,lanes,bytes,calls,seconds,mbps,cpb,cpc,p50ns,p99ns,speedup\n");
+  for (p = 0; p < sizeof (Prim) / sizeof (Prim[0]); ++p) {
+    kn = Prim[p].k();
+    for (s = 0; s < sizeof (Size) / sizeof (Size[0]); ++s)
+      base[s] = 0;
+    for (k = 0; k < (Prim[p].sel ? sizeof (Kern) / sizeof (Kern[0]) : 1); ++k) {
+      if (Prim[p].sel && Prim[p].sel(Kern[k]))
+        continue; /* not in this build, or not on this CPU */
+      for (s = 0; s < sizeof (Size) / sizeof (Size[0]) && (unsigned long long)Size[s] * Prim[p].lanes <= max; ++s) {
+        Prim[p].f(m, Size[s]); /* warm */
+        for (n = 1;; n *= 2) {
+          c = ticks();
+          t = now();
+          for (i = 0; i < n; ++i)
+            Prim[p].f(m, Size[s]);
+          t = now() - t;
+          c = ticks() - c;
+          if (t >= BUDGET)
+            break;
+        }
+        b = (double)Size[s] * Prim[p].lanes;
+        r = n / t;
+        printf("%s,%s,%u,%u,%lu,%.6f,%.2f,", Prim[p].name, Prim[p].k(), Prim[p].lanes, Size[s], n, t, b * r / 1e6);
+        if (c && b)
+          printf("%.3f", (double)c / (b * n));
+        printf(",");
+        if (c)
+          printf("%.1f", (double)c / n);
+        printf(",");
+        if (Size[s] <= SMALL) {
+          for (i = 0; i < SAMPLES; ++i) {
+            t = now();
+            Prim[p].f(m, Size[s]);
+            lat[i] = (now() - t) * 1e9;
+          }
+          qsort(lat, SAMPLES, sizeof (lat[0]), cmp);
+          printf("%.0f,%.0f", lat[SAMPLES / 2], lat[SAMPLES * 99 / 100]);
+        } else
+          printf(",");
+        printf(",");
+        if (Prim[p].sel && !strcmp(Prim[p].k(), "unroll"))
+          base[s] = r;
+        if (Prim[p].sel && base[s] > 0)
+          printf("%.2f", r / base[s]);
+        printf("\n");
+        fflush(stdout);
+      }
+    }
+    if (Prim[p].sel)
+      Prim[p].sel(kn);
+  }
+  free(m);
+  free(P320);
+  free(P160);
+  free(K320);
+  free(K160);
+  free(C320);
+  free(C160);
+  return (0);
+}
@@ -0,0 +1,443 @@
+#define _DEFAULT_SOURCE /* madvise */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "rmd160cd.h"
+
+/*
+ * rmd160cd [-j threads] [-n chunks] [path ...]
+ *  Cut the inputs (standard input if none) into content defined chunks
+ *  and report how many are distinct, and the bytes they hold.
+ * rmd160cd -s [-j threads] [megabytes]
+ *  Run synthetic streams of known dedup ratio through the same pipeline
+ *  and write CSV: known,measured,bytes,chunks,unique,threads,seconds,MB/s
+ * This thread cuts, which is cheap; the workers hash BATCH chunks at a time
+ * through the batch lanes and add the digests to one shared table, which
+ * maps each distinct digest to the number of the chunk first seen with it.
+ * -n sizes the table, by default for every chunk of the regular files
+ * being smallest and 1M more for each pipe.
+ */
+
+#define BATCH 64                  /* chunks per unit of work */
+#define QUEUE 64                  /* units of work waiting */
+#define SEGSZ (8U * 1024U * 1024U) /* read() size for pipes */
+#define PIPE (1024U * 1024U)      /* table room for each pipe */
+
+struct seg {
+  unsigned char *b;
+  size_t z;
+  int m;          /* 1 mapped, 0 allocated, -1 owned by the caller */
+  unsigned int r; /* units of work using it, + 1 while being cut */
+};
+
+struct unit {
+  struct seg *s;
+  const unsigned char *d[BATCH];
+  unsigned int l[BATCH];
+  unsigned int n;
+  size_t c;       /* number of the first chunk */
+};
+
+static const char *Me = "rmd160cd";
+static rmd160cdix_t *Ix;
+static struct unit Q[QUEUE];
+static unsigned int Qh;   /* next to take */
+static unsigned int Qt;   /* next to fill */
+static int Eof;           /* no more units */
+static int Full;
+static size_t Chunks;
+static size_t Unique;
+static unsigned long long Bytes;
+static unsigned long long Stored;
+static pthread_mutex_t M = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Cq = PTHREAD_COND_INITIALIZER; /* a unit was queued, or Eof */
+static pthread_cond_t Cs = PTHREAD_COND_INITIALIZER; /* a unit was taken */
+
+static void
+release(
+  struct seg *s
+){
+  unsigned int r;
+
+  pthread_mutex_lock(&M);
+  r = --s->r;
+  pthread_mutex_unlock(&M);
+  if (r)
+    return;
+  if (s->m > 0)
+    munmap(s->b, s->z);
+  else if (!s->m)
+    free(s->b);
+  free(s);
+}
+
+static void *
+worker(
+  void *a
+){
+  unsigned char h[BATCH * RMD160_SZ];
+  struct unit u;
+  unsigned long long b;
+  size_t n;
+  unsigned int i;
+  int f;
+
+  (void)a;
+  for (;;) {
+    pthread_mutex_lock(&M);
+    while (Qh == Qt && !Eof)
+      pthread_cond_wait(&Cq, &M);
+    if (Qh == Qt) {
+      pthread_mutex_unlock(&M);
+      break;
+    }
+    u = Q[Qh++ % QUEUE];
+    pthread_cond_signal(&Cs);
+    pthread_mutex_unlock(&M);
+    rmd160cdhashn(u.n, u.d, u.l, h);
+    for (b = 0, n = 0, f = 0, i = 0; i < u.n; ++i)
+      switch (rmd160cdixput(Ix, h + i * RMD160_SZ, u.c + i, 0)) {
+      case 1:
+        ++n;
+        b += u.l[i];
+        break;
+      case -1:
+        f = 1;
+        break;
+      }
+    pthread_mutex_lock(&M);
+    Unique += n;
+    Stored += b;
+    Full |= f;
+    pthread_mutex_unlock(&M);
+    release(u.s);
+  }
+  return (0);
+}
+
+static void
+queue(
+  struct unit *u
+){
+  if (!u->n)
+    return;
+  pthread_mutex_lock(&M);
+  while (Qt - Qh == QUEUE)
+    pthread_cond_wait(&Cs, &M);
+  ++u->s->r;
+  Q[Qt++ % QUEUE] = *u;
+  Chunks += u->n;
+  pthread_cond_signal(&Cq);
+  pthread_mutex_unlock(&M);
+  u->c += u->n;
+  u->n = 0;
+}
+
+/* queue the chunks of l bytes of s from d, returns the bytes left uncut unless e */
+static size_t
+cut(
+  struct seg *s
+ ,struct unit *u
+ ,const unsigned char *d
+ ,size_t l
+ ,int e
+){
+  unsigned int t;
+
+  u->s = s;
+  for (; l; d += t, l -= t) {
+    t = rmd160cdcut(d, l);
+    if (!e && t == l && t < RMD160_CDMAX)
+      break;
+    u->d[u->n] = d;
+    u->l[u->n] = t;
+    if (++u->n == BATCH)
+      queue(u);
+  }
+  queue(u);
+  return (l);
+}
+
+static struct seg *
+segment(
+  unsigned char *b
+ ,size_t z
+ ,int m
+){
+  struct seg *s;
+
+  if (!(s = malloc(sizeof (*s)))) {
+    fprintf(stderr, "%s: out of memory\n", Me);
+    exit(2);
+  }
+  s->b = b;
+  s->z = z;
+  s->m = m;
+  s->r = 1;
+  return (s);
+}
+
+/* cut a pipe SEGSZ at a time, carrying each uncut tail to the next segment */
+static int
+streamed(
+  struct unit *u
+ ,int f
+){
+  unsigned char *b;
+  struct seg *s;
+  size_t k; /* bytes carried */
+  size_t n;
+  ssize_t i;
+  int e;
+
+  s = 0;
+  for (k = 0, e = 0; !e;) {
+    if (!(b = malloc(SEGSZ + RMD160_CDMAX))) {
+      fprintf(stderr, "%s: out of memory\n", Me);
+      exit(2);
+    }
+    if (k)
+      memcpy(b, s->b + s->z - k, k);
+    for (n = k; n < SEGSZ && !e;)
+      if ((i = read(f, b + n, SEGSZ + RMD160_CDMAX - n)) > 0)
+        n += (size_t)i;
+      else if (!i)
+        e = 1;
+      else if (errno != EINTR) {
+        free(b);
+        if (k)
+          release(s);
+        return (errno);
+      }
+    Bytes += n - k;
+    if (k)
+      release(s);
+    s = segment(b, n, 0);
+    if ((k = cut(s, u, b, n, e)) == 0)
+      release(s);
+  }
+  return (0);
+}
+
+static int
+input(
+  struct unit *u
+ ,const char *p
+){
+  struct stat t;
+  void *m;
+  int f;
+  int r;
+
+  if (!strcmp(p, "-"))
+    f = 0;
+  else if ((f = open(p, O_RDONLY)) < 0)
+    return (errno);
+  if (!fstat(f, &t) && S_ISREG(t.st_mode) && t.st_size > 0
+   && (m = mmap(0, (size_t)t.st_size, PROT_READ, MAP_PRIVATE, f, 0)) != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+    madvise(m, (size_t)t.st_size, MADV_SEQUENTIAL);
+#endif
+    Bytes += (unsigned long long)t.st_size;
+    cut(segment(m, (size_t)t.st_size, 1), u, m, (size_t)t.st_size, 1);
+    release(u->s);
+    r = 0;
+  } else
+    r = streamed(u, f);
+  if (f)
+    close(f);
+  return (r);
+}
+
+static pthread_t *
+start(
+  unsigned int n
+){
+  pthread_t *t;
+  unsigned int i;
+
+  if (!(t = malloc(n * sizeof (*t)))) {
+    fprintf(stderr, "%s: out of memory\n", Me);
+    exit(2);
+  }
+  Qh = Qt = 0;
+  Eof = Full = 0;
+  Chunks = Unique = 0;
+  Bytes = Stored = 0;
+  for (i = 0; i < n; ++i)
+    if (pthread_create(t + i, 0, worker, 0)) {
+      fprintf(stderr, "%s: cannot start threads\n", Me);
+      exit(2);
+    }
+  return (t);
+}
+
+static void
+finish(
+  pthread_t *t
+ ,unsigned int n
+){
+  unsigned int i;
+
+  pthread_mutex_lock(&M);
+  Eof = 1;
+  pthread_cond_broadcast(&Cq);
+  pthread_mutex_unlock(&M);
+  for (i = 0; i < n; ++i)
+    pthread_join(t[i], 0);
+  free(t);
+}
+
+static double
+now(
+  void
+){
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (t.tv_sec + t.tv_nsec / 1e9);
+}
+
+/*
+ * r copies of z random bytes, each behind a few bytes of its own and with
+ * a few bytes changed every MiB, so r is the dedup ratio less the chunks
+ * those edits touch: a shifted copy costs only the chunks near the shift.
+ */
+static int
+synthetic(
+  unsigned int n
+ ,size_t z
+){
+  static const unsigned int Ratio[] = { 1, 2, 4, 8 };
+  unsigned long long x;
+  unsigned char *b;
+  unsigned char *p;
+  pthread_t *t;
+  struct unit u;
+  size_t l;
+  size_t i;
+  unsigned int k;
+  unsigned int c;
+  double s;
+
+  printf("known,measured,bytes,chunks,unique,threads,seconds,mbps\n");
+  for (k = 0; k < sizeof (Ratio) / sizeof (Ratio[0]); ++k) {
+    l = Ratio[k] * (z + 128);
+    if (!(b = malloc(l)) || !(Ix = malloc(rmd160cdixtsize(l / RMD160_CDMIN + 1)))) {
+      fprintf(stderr, "%s: out of memory\n", Me);
+      return (2);
+    }
+    rmd160cdixinit(Ix, l / RMD160_CDMIN + 1);
+    x = 0x9e3779b97f4a7c15ULL;
+    for (p = b, c = 0; c < Ratio[k]; ++c) {
+      for (i = 0; i < 64 + c * 7 % 64 && p < b + l; ++i) {
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+        *p++ = (unsigned char)(x >> 32);
+      }
+      if (!c)
+        for (i = 0; i < z; ++i) {
+          x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+          p[i] = (unsigned char)(x >> 32);
+        }
+      else
+        memcpy(p, b + 64, z);
+      for (i = c ? (size_t)c * 4099 % (1U << 20) : z; i < z; i += 1U << 20)
+        p[i] ^= (unsigned char)(c + 1);
+      p += z;
+    }
+    l = (size_t)(p - b);
+    t = start(n);
+    s = now();
+    memset(&u, 0, sizeof (u));
+    Bytes = l;
+    cut(segment(b, l, -1), &u, b, l, 1);
+    release(u.s);
+    finish(t, n);
+    s = now() - s;
+    printf("%u,%.3f,%llu,%zu,%zu,%u,%.3f,%.1f\n", Ratio[k], (double)Bytes / (double)Stored
+     , Bytes, Chunks, Unique, n, s, (double)Bytes / s / 1e6);
+    fflush(stdout);
+    free(Ix);
+    free(b);
+  }
+  return (0);
+}
+
+int
+main(
+  int argc
+ ,char *argv[]
+){
+  struct unit u;
+  struct stat s;
+  pthread_t *t;
+  size_t c;
+  long j;
+  int y;
+  int a;
+  int r;
+  int e;
+
+  j = 0;
+  c = 0;
+  y = 0;
+  for (a = 1; a < argc && argv[a][0] == '-' && argv[a][1]; ++a)
+    if (!strcmp(argv[a], "--")) {
+      ++a;
+      break;
+    } else if (!strcmp(argv[a], "-s"))
+      y = 1;
+    else if (!strcmp(argv[a], "-j") && a + 1 < argc && (j = strtol(argv[++a], 0, 10)) > 0)
+      ;
+    else if (!strcmp(argv[a], "-n") && a + 1 < argc && (c = strtoul(argv[++a], 0, 10)) > 0)
+      ;
+    else {
+      fprintf(stderr, "usage: %s [-j threads] [-n chunks] [path ...] | %s -s [-j threads] [megabytes]\n", Me, Me);
+      return (2);
+    }
+  if (j <= 0 && (j = sysconf(_SC_NPROCESSORS_ONLN)) <= 0)
+    j = 1;
+  if (y)
+    return (synthetic((unsigned int)j, (a < argc ? strtoul(argv[a], 0, 10) : 64) << 20));
+  if (!c) {
+    for (r = a; r < argc; ++r)
+      if (strcmp(argv[r], "-") && !stat(argv[r], &s) && S_ISREG(s.st_mode))
+        c += (size_t)s.st_size / RMD160_CDMIN + 1;
+      else
+        c += PIPE;
+    if (a == argc)
+      c += PIPE;
+  }
+  if (!(Ix = malloc(rmd160cdixtsize(c)))) {
+    fprintf(stderr, "%s: out of memory\n", Me);
+    return (2);
+  }
+  rmd160cdixinit(Ix, c);
+  t = start((unsigned int)j);
+  memset(&u, 0, sizeof (u));
+  e = 0;
+  if (a == argc)
+    argv[--a] = "-";
+  for (; a < argc; ++a)
+    if ((r = input(&u, argv[a]))) {
+      fprintf(stderr, "%s: %s: %s\n", Me, argv[a], strerror(r));
+      e = 1;
+    }
+  finish(t, (unsigned int)j);
+  free(Ix);
+  if (Full) {
+    fprintf(stderr, "%s: more than %zu distinct chunks, use -n\n", Me, c);
+    return (2);
+  }
+  printf("%llu bytes in %zu chunks, %zu distinct holding %llu bytes, ratio %.3f\n"
+   , Bytes, Chunks, Unique, Stored, Stored ? (double)Bytes / (double)Stored : 1.0);
+  return (e);
+}
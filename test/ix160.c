@@ -0,0 +1,192 @@
+#define _DEFAULT_SOURCE /* getline, madvise */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "rmd160ix.h"
+
+/*
+ * rmd160ix -b index
+ *  Build index from the digests that begin the lines of standard input
+ *  (such as rmd160 output), repeats dropped.
+ * rmd160ix [-v] index
+ *  Write the lines of standard input whose leading digest is in index
+ *  (with -v, is not), exiting 0 if any line was written, like grep.
+ * The index is mapped, and lines are looked up BATCH at a time.
+ */
+
+#define HX (2 * RMD160_SZ) /* hex digest length */
+#define BATCH 4096         /* lines per lookup */
+
+static const char *Me = "rmd160ix";
+
+/* write all z bytes of t to path p */
+static int
+save(
+  const char *p
+ ,const unsigned char *t
+ ,size_t z
+){
+  ssize_t l;
+  int f;
+
+  if ((f = open(p, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+    fprintf(stderr, "%s: %s: %s\n", Me, p, strerror(errno));
+    return (2);
+  }
+  for (; z; t += l, z -= (size_t)l)
+    if ((l = write(f, t, z)) < 0 && errno != EINTR) {
+      fprintf(stderr, "%s: %s: %s\n", Me, p, strerror(errno));
+      close(f);
+      return (2);
+    } else if (l < 0)
+      l = 0;
+  if (close(f)) {
+    fprintf(stderr, "%s: %s: %s\n", Me, p, strerror(errno));
+    return (2);
+  }
+  return (0);
+}
+
+static int
+build(
+  const char *p
+){
+  unsigned char h[RMD160_SZ];
+  unsigned char *d;
+  unsigned char *t;
+  char *b;
+  size_t a;
+  size_t n;
+  size_t m;
+  size_t o;
+  ssize_t l;
+  unsigned int k;
+  unsigned int s;
+  int r;
+
+  d = 0;
+  b = 0;
+  a = 0;
+  for (n = m = 0, s = 1; (l = getline(&b, &a, stdin)) > 0; ++s) {
+    if (l < HX || rmd160unhex(b, h) >= 0) {
+      fprintf(stderr, "%s: %u: improperly formatted line\n", Me, s);
+      continue;
+    }
+    if (n == m) {
+      if (!(t = realloc(d, (m = m ? 2 * m : BATCH) * RMD160_SZ))) {
+        fprintf(stderr, "%s: out of memory\n", Me);
+        free(d);
+        free(b);
+        return (2);
+      }
+      d = t;
+    }
+    memcpy(d + n++ * RMD160_SZ, h, RMD160_SZ);
+  }
+  free(b);
+  /* a few digests per bucket, and the digests moved up to where the index keeps them */
+  for (k = 0; k < 24 && n >> (k + 4); ++k);
+  o = rmd160ixsize(0, k);
+  if (!(t = realloc(d, rmd160ixsize(n, k)))) {
+    fprintf(stderr, "%s: out of memory\n", Me);
+    free(d);
+    return (2);
+  }
+  if (n)
+    memmove(t + o, t, n * RMD160_SZ);
+  r = save(p, t, rmd160ixbuild(t, t + o, n, k));
+  free(t);
+  return (r);
+}
+
+/* write each of the n lines in l whose digest is (or with v, is not) found */
+static size_t
+emit(
+  const rmd160ix_t *x
+ ,char **l
+ ,unsigned char *h
+ ,unsigned char *r
+ ,size_t n
+ ,int v
+){
+  size_t c;
+  size_t i;
+
+  rmd160ixfindn(x, n, h, r);
+  for (c = i = 0; i < n; ++i)
+    if (!r[i] == !!v) {
+      fputs(l[i], stdout);
+      ++c;
+    }
+  return (c);
+}
+
+static int
+lookup(
+  const char *p
+ ,int v
+){
+  static char *l[BATCH];
+  static unsigned char h[BATCH][RMD160_SZ];
+  static unsigned char r[BATCH];
+  static size_t a[BATCH];
+  struct stat s;
+  rmd160ix_t *x;
+  void *m;
+  size_t c;
+  size_t n;
+  size_t i;
+  unsigned int e;
+  int f;
+
+  if ((f = open(p, O_RDONLY)) < 0 || fstat(f, &s)) {
+    fprintf(stderr, "%s: %s: %s\n", Me, p, strerror(errno));
+    return (2);
+  }
+  if (!s.st_size || (m = mmap(0, (size_t)s.st_size, PROT_READ, MAP_SHARED, f, 0)) == MAP_FAILED)
+    m = 0;
+  close(f);
+  if (!m || !(x = rmd160ixopen(m, (size_t)s.st_size))) {
+    fprintf(stderr, "%s: %s: not an index\n", Me, p);
+    if (m)
+      munmap(m, (size_t)s.st_size);
+    return (2);
+  }
+  madvise(m, (size_t)s.st_size, MADV_RANDOM);
+  for (c = n = 0, e = 1; getline(l + n, a + n, stdin) > 0; ++e) {
+    if (strlen(l[n]) < HX || rmd160unhex(l[n], h[n]) >= 0) {
+      fprintf(stderr, "%s: %u: improperly formatted line\n", Me, e);
+      continue;
+    }
+    if (++n == BATCH) {
+      c += emit(x, l, h[0], r, n, v);
+      n = 0;
+    }
+  }
+  c += emit(x, l, h[0], r, n, v);
+  for (i = 0; i < BATCH; ++i)
+    free(l[i]);
+  munmap(m, (size_t)s.st_size);
+  return (!c);
+}
+
+int
+main(
+  int argc
+ ,char *argv[]
+){
+  if (argc == 3 && !strcmp(argv[1], "-b"))
+    return (build(argv[2]));
+  if (argc == 3 && !strcmp(argv[1], "-v"))
+    return (lookup(argv[2], 1));
+  if (argc == 2 && argv[1][0] != '-')
+    return (lookup(argv[1], 0));
+  fprintf(stderr, "usage: %s -b index | %s [-v] index\n", Me, Me);
+  return (2);
+}
@@ -3,6 +3,9 @@
 #include <string.h>
 #include "rmd160.h"
 #include "rmd320.h"
+#include "rmd160mt.h"
+#include "rmd160ix.h"
+#include "rmd160cd.h"
 
 /* Spec vectors from https://homes.esat.kuleuven.be/~bosselae/ripemd160.html */
 struct svec {
@@ -67,6 +70,133 @@ check(
   return (1);
 }
 
+/* hex both ways: every byte value, mixed case, a bad character at every offset */
+static int
+hex160(
+  const char *label
+){
+  static const char Bad[] = "g/:@G`\x80 ";
+  unsigned char d[13 * RMD160_SZ];
+  unsigned char e[13 * RMD160_SZ];
+  char x[13 * (2 * RMD160_SZ + 2)];
+  char r[2 * RMD160_SZ + 1];
+  char t[2 * RMD160_SZ + 1];
+  unsigned int i;
+  unsigned int j;
+  int f;
+
+  f = 0;
+  for (i = 0; i < sizeof (d); ++i)
+    d[i] = (unsigned char)(i * 7);
+  rmd160hexn(13, d, x, 2 * RMD160_SZ + 2);
+  for (i = 0; i < 13; ++i) {
+    hexof(d + i * RMD160_SZ, RMD160_SZ, r);
+    memcpy(t, x + i * (2 * RMD160_SZ + 2), 2 * RMD160_SZ);
+    t[2 * RMD160_SZ] = 0;
+    f += check(label, t, r);
+  }
+  for (i = 0; i < sizeof (x); i += 3)
+    if (x[i] >= 'a' && x[i] <= 'f')
+      x[i] -= 'a' - 'A';
+  f += rmd160unhexn(13, x, 2 * RMD160_SZ + 2, e) != 13 || memcmp(d, e, sizeof (d));
+  for (j = 0; j < 2 * RMD160_SZ; ++j)
+    for (i = 0; i < sizeof (Bad) - 1; ++i) {
+      memcpy(t, x, 2 * RMD160_SZ);
+      t[j] = Bad[i];
+      f += rmd160unhex(t, e) != (int)j;
+    }
+  x[5 * (2 * RMD160_SZ + 2) + 3] = 'z';
+  f += rmd160unhexn(13, x, 2 * RMD160_SZ + 2, e) != 5;
+  if (f)
+    fprintf(stderr, "FAIL %s: rmd160 hex\n", label);
+  return (f);
+}
+
+/* hex both ways: every byte value, mixed case, a bad character at every offset */
+static int
+hex320(
+  const char *label
+){
+  static const char Bad[] = "g/:@G`\x80 ";
+  unsigned char d[13 * RMD320_SZ];
+  unsigned char e[13 * RMD320_SZ];
+  char x[13 * (2 * RMD320_SZ + 2)];
+  char r[2 * RMD320_SZ + 1];
+  char t[2 * RMD320_SZ + 1];
+  unsigned int i;
+  unsigned int j;
+  int f;
+
+  f = 0;
+  for (i = 0; i < sizeof (d); ++i)
+    d[i] = (unsigned char)(i * 7);
+  rmd320hexn(13, d, x, 2 * RMD320_SZ + 2);
+  for (i = 0; i < 13; ++i) {
+    hexof(d + i * RMD320_SZ, RMD320_SZ, r);
+    memcpy(t, x + i * (2 * RMD320_SZ + 2), 2 * RMD320_SZ);
+    t[2 * RMD320_SZ] = 0;
+    f += check(label, t, r);
+  }
+  for (i = 0; i < sizeof (x); i += 3)
+    if (x[i] >= 'a' && x[i] <= 'f')
+      x[i] -= 'a' - 'A';
+  f += rmd320unhexn(13, x, 2 * RMD320_SZ + 2, e) != 13 || memcmp(d, e, sizeof (d));
+  for (j = 0; j < 2 * RMD320_SZ; ++j)
+    for (i = 0; i < sizeof (Bad) - 1; ++i) {
+      memcpy(t, x, 2 * RMD320_SZ);
+      t[j] = Bad[i];
+      f += rmd320unhex(t, e) != (int)j;
+    }
+  x[5 * (2 * RMD320_SZ + 2) + 3] = 'z';
+  f += rmd320unhexn(13, x, 2 * RMD320_SZ + 2, e) != 5;
+  if (f)
+    fprintf(stderr, "FAIL %s: rmd320 hex\n", label);
+  return (f);
+}
+
+/* tree hash leaf (b 0x00) or node (b 0x01) straight from the definition */
+static void
+tree160(
+  rmd160_t *c
+ ,unsigned char b
+ ,const unsigned char *d
+ ,unsigned int l
+ ,const unsigned char *r
+ ,unsigned char *h
+){
+  unsigned char p[64];
+
+  memset(p, 0, sizeof (p));
+  p[0] = b;
+  rmd160init(c);
+  rmd160update(c, p, sizeof (p));
+  rmd160update(c, d, l);
+  if (r)
+    rmd160update(c, r, RMD160_SZ);
+  rmd160final(c, h);
+}
+
+static void
+tree320(
+  rmd320_t *c
+ ,unsigned char b
+ ,const unsigned char *d
+ ,unsigned int l
+ ,const unsigned char *r
+ ,unsigned char *h
+){
+  unsigned char p[64];
+
+  memset(p, 0, sizeof (p));
+  p[0] = b;
+  rmd320init(c);
+  rmd320update(c, p, sizeof (p));
+  rmd320update(c, d, l);
+  if (r)
+    rmd320update(c, r, RMD320_SZ);
+  rmd320final(c, h);
+}
+
 int
 main(
   void
@@ -80,23 +210,54 @@ main(
   static const char Hd2[] = "what do ya want for nothing?";
   static unsigned char Hk6[80];
   static const char Hd6[] = "Test Using Larger Than Block-Size Key - Hash Key First";
+  static const char Hi[] = "f0f1f2f3f4f5f6f7f8f9";
   static const char Msg[] =
     "The quick brown fox jumps over the lazy dog."
     "The quick brown fox jumps over the lazy dog."
     "The quick brown fox jumps over the lazy dog."
     "The quick brown fox jumps over the lazy dog.";
   static const unsigned int Chunks[] = { 1, 7, 31, 55, 56, 63, 64, 65, 88, 127, 128 };
+  static const unsigned int Lanes[] = { 0, 1, 55, 56, 63, 64, 119, 160, 2, 57, 65, 100, 120, 127, 128, 129 };
+  static const char *const Kern160[] = { "loop", "unroll", "avx2", "avx512" };
+  static const char *const Kern320[] = { "loop", "unroll", "avx512" };
+  static void (*const Fix160[])(const unsigned char *, unsigned char *) = { rmd160fix20, rmd160fix32, rmd160fix33, rmd160fix65 };
+  static void (*const Fix320[])(const unsigned char *, unsigned char *) = { rmd320fix20, rmd320fix32, rmd320fix33, rmd320fix65 };
+  static const unsigned int Fixl[] = { 20, 32, 33, 65 };
+  static const unsigned int Pfxl[] = { 0, 37, 64, 128 };
   rmd160_t *c160;
   rmd320_t *c320;
+  rmd160hkey_t *k160;
+  rmd320hkey_t *k320;
+  rmd160hmac_t *m160;
+  rmd320hmac_t *m320;
+  rmd160tree_t *t160;
+  rmd320tree_t *t320;
+  unsigned char tl[5][RMD320_SZ];
+  unsigned char *big;
+  rmd160mt_t *mt;
+  unsigned char pf[64 * RMD160_SZ];
+  unsigned char mf[1256];
+  unsigned char mb[19 * RMD160_SZ];
   unsigned char h160[RMD160_SZ];
   unsigned char h320[RMD320_SZ];
   char b160[2 * RMD160_SZ + 1];
   char b320[2 * RMD320_SZ + 1];
   char ref160[2 * RMD160_SZ + 1];
   char ref320[2 * RMD320_SZ + 1];
+  unsigned char okm[82];
+  const unsigned char *id[19];
+  unsigned int il[19];
+  unsigned char *io[19];
+  unsigned char ob[19][sizeof (okm)];
+  char ref[2 * sizeof (okm) + 1];
+  char bo[2 * sizeof (okm) + 1];
+  const unsigned char *bd[16];
+  unsigned int bl[16];
+  unsigned char hb[16 * RMD320_SZ];
   unsigned char *mega;
   unsigned int msglen;
   unsigned int q;
+  unsigned int k;
   unsigned int off;
   unsigned int n;
   int fail;
@@ -125,6 +286,13 @@ main(
     rmd320final(c320, h320);
     hexof(h320, RMD320_SZ, b320);
     fail += check("rmd320 spec", b320, Svec[q].h320);
+
+    rmd160((const unsigned char *)Svec[q].in, Svec[q].inlen, h160);
+    hexof(h160, RMD160_SZ, b160);
+    fail += check("rmd160 one call", b160, Svec[q].h160);
+    rmd320((const unsigned char *)Svec[q].in, Svec[q].inlen, h320);
+    hexof(h320, RMD320_SZ, b320);
+    fail += check("rmd320 one call", b320, Svec[q].h320);
   }
 
   /* Million-'a' */
@@ -140,13 +308,34 @@ main(
   rmd160final(c160, h160);
   hexof(h160, RMD160_SZ, b160);
   fail += check("rmd160 million-a", b160, "52783243c1697bdbe16d37f97f68f08325dc1528");
+  rmd160(mega, 1000000, h160);
+  hexof(h160, RMD160_SZ, b160);
+  fail += check("rmd160 one call million-a", b160, "52783243c1697bdbe16d37f97f68f08325dc1528");
 
   rmd320init(c320);
   rmd320update(c320, mega, 1000000);
   rmd320final(c320, h320);
   hexof(h320, RMD320_SZ, b320);
   fail += check("rmd320 million-a", b320, "bdee37f4371e20646b8b0d862dda16292ae36f40965e8c8509e63d1dbddecc503e2b63eb9245bb66");
-  free(mega);
+  rmd320(mega, 1000000, h320);
+  hexof(h320, RMD320_SZ, b320);
+  fail += check("rmd320 one call million-a", b320, "bdee37f4371e20646b8b0d862dda16292ae36f40965e8c8509e63d1dbddecc503e2b63eb9245bb66");
+  for (q = 0; q < sizeof (Lanes) / sizeof (Lanes[0]); ++q) {
+    rmd160init(c160);
+    rmd160update(c160, mega, Lanes[q]);
+    rmd160final(c160, h160);
+    hexof(h160, RMD160_SZ, ref160);
+    rmd160(mega, Lanes[q], h160);
+    hexof(h160, RMD160_SZ, b160);
+    fail += check("rmd160 one call tail", b160, ref160);
+    rmd320init(c320);
+    rmd320update(c320, mega, Lanes[q]);
+    rmd320final(c320, h320);
+    hexof(h320, RMD320_SZ, ref320);
+    rmd320(mega, Lanes[q], h320);
+    hexof(h320, RMD320_SZ, b320);
+    fail += check("rmd320 one call tail", b320, ref320);
+  }
 
   /* Streaming-boundary equivalence: one-shot vs chunk-by-chunk at sizes
      that straddle the 64-byte block buffer */
@@ -167,7 +356,7 @@ main(
       if (off + n > msglen)
         n = msglen - off;
       rmd160update(c160, (const unsigned char *)Msg + off, n);
-      rmd320update(c320, (const unsigned char *)Msg + off, n);
+      rmd320updatez(c320, (const unsigned char *)Msg + off, n);
     }
     rmd160final(c160, h160);
     rmd320final(c320, h320);
@@ -177,6 +366,100 @@ main(
     fail += check("rmd320 stream", b320, ref320);
   }
 
+  /* Batch: each lane against the scalar digest of the same message */
+  for (q = 0; q < 16; ++q) {
+    bd[q] = (const unsigned char *)Msg + q;
+    bl[q] = Lanes[q];
+  }
+  rmd160x8(bd, bl, hb);
+  for (q = 0; q < 8; ++q) {
+    rmd160init(c160);
+    rmd160update(c160, bd[q], bl[q]);
+    rmd160final(c160, h160);
+    hexof(h160, RMD160_SZ, ref160);
+    hexof(hb + q * RMD160_SZ, RMD160_SZ, b160);
+    fail += check("rmd160x8", b160, ref160);
+  }
+  rmd160x16(bd, bl, hb);
+  for (q = 0; q < 16; ++q) {
+    rmd160init(c160);
+    rmd160update(c160, bd[q], bl[q]);
+    rmd160final(c160, h160);
+    hexof(h160, RMD160_SZ, ref160);
+    hexof(hb + q * RMD160_SZ, RMD160_SZ, b160);
+    fail += check("rmd160x16", b160, ref160);
+  }
+  rmd320x16(bd, bl, hb);
+  for (q = 0; q < 16; ++q) {
+    rmd320init(c320);
+    rmd320update(c320, bd[q], bl[q]);
+    rmd320final(c320, h320);
+    hexof(h320, RMD320_SZ, ref320);
+    hexof(hb + q * RMD320_SZ, RMD320_SZ, b320);
+    fail += check("rmd320x16", b320, ref320);
+  }
+
+  /* Kernels: every one this build can run against the spec vectors,
+     singly and as batch lanes (the eight vectors twice over), and the
+     million-a chained through one call */
+  for (q = 0; q < 16; ++q) {
+    bd[q] = (const unsigned char *)Svec[q % 8].in;
+    bl[q] = Svec[q % 8].inlen;
+  }
+  for (k = 0; k < sizeof (Kern160) / sizeof (Kern160[0]); ++k) {
+    if (rmd160kernel(Kern160[k]))
+      continue;
+    for (q = 0; q < 8; ++q) {
+      rmd160init(c160);
+      rmd160update(c160, bd[q], bl[q]);
+      rmd160final(c160, h160);
+      hexof(h160, RMD160_SZ, b160);
+      fail += check(Kern160[k], b160, Svec[q].h160);
+    }
+    rmd160(mega, 1000000, h160);
+    hexof(h160, RMD160_SZ, b160);
+    fail += check(Kern160[k], b160, "52783243c1697bdbe16d37f97f68f08325dc1528");
+    rmd160x8(bd, bl, hb);
+    for (q = 0; q < 8; ++q) {
+      hexof(hb + q * RMD160_SZ, RMD160_SZ, b160);
+      fail += check(Kern160[k], b160, Svec[q].h160);
+    }
+    rmd160x16(bd, bl, hb);
+    for (q = 0; q < 16; ++q) {
+      hexof(hb + q * RMD160_SZ, RMD160_SZ, b160);
+      fail += check(Kern160[k], b160, Svec[q % 8].h160);
+    }
+    fail += hex160(Kern160[k]);
+  }
+  rmd160kernel(0);
+  for (k = 0; k < sizeof (Kern320) / sizeof (Kern320[0]); ++k) {
+    if (rmd320kernel(Kern320[k]))
+      continue;
+    for (q = 0; q < 8; ++q) {
+      rmd320init(c320);
+      rmd320update(c320, bd[q], bl[q]);
+      rmd320final(c320, h320);
+      hexof(h320, RMD320_SZ, b320);
+      fail += check(Kern320[k], b320, Svec[q].h320);
+    }
+    rmd320(mega, 1000000, h320);
+    hexof(h320, RMD320_SZ, b320);
+    fail += check(Kern320[k], b320, "bdee37f4371e20646b8b0d862dda16292ae36f40965e8c8509e63d1dbddecc503e2b63eb9245bb66");
+    rmd320hex(h320, b320); /* 40 bytes through the vector hex above "loop" */
+    b320[2 * RMD320_SZ] = 0;
+    fail += check(Kern320[k], b320, "bdee37f4371e20646b8b0d862dda16292ae36f40965e8c8509e63d1dbddecc503e2b63eb9245bb66");
+    fail += rmd320unhex("BDEE37F4371E20646B8B0D862DDA16292AE36F40965E8C8509E63D1DBDDECC503E2B63EB9245BB66", hb) != -1
+     || memcmp(hb, h320, RMD320_SZ);
+    rmd320x16(bd, bl, hb);
+    for (q = 0; q < 16; ++q) {
+      hexof(hb + q * RMD320_SZ, RMD320_SZ, b320);
+      fail += check(Kern320[k], b320, Svec[q % 8].h320);
+    }
+    fail += hex320(Kern320[k]);
+  }
+  rmd320kernel(0);
+  free(mega);
+
   /* HMAC-RIPEMD-160 from RFC 2286 */
   rmd160hmac(Hk1, sizeof (Hk1)
             ,(const unsigned char *)Hd1, sizeof (Hd1) - 1, h160);
@@ -195,6 +478,11 @@ main(
   hexof(h160, RMD160_SZ, b160);
   fail += check("hmac-rmd160 t6", b160, "6466ca07ac5eac29e1bd523e5ada7605b791fd8b");
 
+  rmd160hmacz(Hk6, sizeof (Hk6)
+             ,(const unsigned char *)Hd6, sizeof (Hd6) - 1, h160);
+  hexof(h160, RMD160_SZ, b160);
+  fail += check("hmac-rmd160 size_t", b160, "6466ca07ac5eac29e1bd523e5ada7605b791fd8b");
+
   /* HMAC-RIPEMD-320: no RFC vectors exist; regression against this impl */
   rmd320hmac(Hk1, sizeof (Hk1)
             ,(const unsigned char *)Hd1, sizeof (Hd1) - 1, h320);
@@ -206,6 +494,476 @@ main(
   hexof(h320, RMD320_SZ, b320);
   fail += check("hmac-rmd320 t6", b320, "a61c1123c1a23ffdd9af5fb28b62b95f989876ac322452f5e4f4470c25182ef4816aaec7f0377167");
 
+  /* HMAC key schedule: one key, several messages */
+  if (!(k160 = malloc(rmd160hkeytsize())) || !(k320 = malloc(rmd320hkeytsize()))) {
+    fprintf(stderr, "FAIL: malloc(hkeytsize)\n");
+    return (1);
+  }
+  rmd160hkeyinit(k160, Hk6, sizeof (Hk6));
+  rmd160hkeymac(k160, (const unsigned char *)Hd1, sizeof (Hd1) - 1, h160);
+  rmd160hkeymac(k160, (const unsigned char *)Hd6, sizeof (Hd6) - 1, h160);
+  hexof(h160, RMD160_SZ, b160);
+  fail += check("hkey-rmd160 t6", b160, "6466ca07ac5eac29e1bd523e5ada7605b791fd8b");
+  rmd160hkeyinit(k160, (const unsigned char *)Hk2, sizeof (Hk2) - 1);
+  rmd160hkeymac(k160, (const unsigned char *)Hd2, sizeof (Hd2) - 1, h160);
+  hexof(h160, RMD160_SZ, b160);
+  fail += check("hkey-rmd160 t2", b160, "dda6c0213a485a9e24f4742064a7f033b43c4069");
+  rmd320hkeyinit(k320, Hk6, sizeof (Hk6));
+  rmd320hkeymac(k320, (const unsigned char *)Hd1, sizeof (Hd1) - 1, h320);
+  rmd320hkeymac(k320, (const unsigned char *)Hd6, sizeof (Hd6) - 1, h320);
+  hexof(h320, RMD320_SZ, b320);
+  fail += check("hkey-rmd320 t6", b320, "a61c1123c1a23ffdd9af5fb28b62b95f989876ac322452f5e4f4470c25182ef4816aaec7f0377167");
+
+  /* HKDF-Expand: no RIPEMD vectors exist; regression against this impl */
+  rmd160hkdf(Hk6, RMD160_SZ, (const unsigned char *)Hi, sizeof (Hi) - 1, okm, 42);
+  hexof(okm, 42, bo);
+  fail += check("hkdf-rmd160 t1", bo, "4005b6af4ee64400eff6fe7aab92199858f6b484c9cd21081381b6a8f961a1cac0095419c1114aea6d88");
+  rmd160hkdfz(Hk6, RMD160_SZ, (const unsigned char *)Hi, sizeof (Hi) - 1, okm, 42);
+  hexof(okm, 42, bo);
+  fail += check("hkdf-rmd160 size_t", bo, "4005b6af4ee64400eff6fe7aab92199858f6b484c9cd21081381b6a8f961a1cac0095419c1114aea6d88");
+  rmd160hkeyinit(k160, Hk6, sizeof (Hk6));
+  rmd160hkeyhkdf(k160, (const unsigned char *)Hi, sizeof (Hi) - 1, okm, 82);
+  hexof(okm, 82, bo);
+  fail += check("hkdf-rmd160 t2", bo, "11964a03482d9d4ec4b95ab11bfffaa302b91cc14d9587055fd1725fabc3f73089c87206b8d3457616efda4140e27e2b243ad5eb37119afbf6294d51318493401e0688797218d3e04cce3faad99e68988945");
+  rmd320hkdf(Hk6, RMD160_SZ, (const unsigned char *)Hi, sizeof (Hi) - 1, okm, 42);
+  hexof(okm, 42, bo);
+  fail += check("hkdf-rmd320 t1", bo, "86ee24002cfe2a5c364451a64af9775a7cd0d5779f395dae233fe7aa6b27cf89251c16607b83a6d72962");
+  rmd320hkeyinit(k320, Hk6, sizeof (Hk6));
+  rmd320hkeyhkdf(k320, (const unsigned char *)Hi, sizeof (Hi) - 1, okm, 82);
+  hexof(okm, 82, bo);
+  fail += check("hkdf-rmd320 t2", bo, "a848be8ed65c914a640ffdbf314b501ad23f8a2fb16f1262deb3ec711bfdb20fca94825f62c4bc5f95e78f7b5a65e09c7914735f6c70d66ef75cb139ea56a9ae8840c9b4a08e59fb1a66bceb5bd7147e9bfc");
+
+  /* HKDF-Extract is HMAC keyed by the salt; batch Expand against single */
+  rmd160hkdfextract((const unsigned char *)Hk2, sizeof (Hk2) - 1
+                   ,(const unsigned char *)Hd2, sizeof (Hd2) - 1, h160);
+  hexof(h160, RMD160_SZ, b160);
+  fail += check("hkdf-rmd160 extract", b160, "dda6c0213a485a9e24f4742064a7f033b43c4069");
+  for (q = 0; q < 19; ++q) {
+    id[q] = (const unsigned char *)Msg + q;
+    il[q] = Lanes[q % 16];
+    io[q] = ob[q];
+  }
+  for (n = 1; n <= 19; n += 9) {
+    rmd160hkeyhkdfn(k160, n, id, il, io, sizeof (okm));
+    for (q = 0; q < n; ++q) {
+      rmd160hkeyhkdf(k160, id[q], il[q], okm, sizeof (okm));
+      hexof(okm, sizeof (okm), ref);
+      hexof(ob[q], sizeof (okm), bo);
+      fail += check("hkdf-rmd160 batch", bo, ref);
+    }
+    rmd320hkeyhkdfn(k320, n, id, il, io, sizeof (okm));
+    for (q = 0; q < n; ++q) {
+      rmd320hkeyhkdf(k320, id[q], il[q], okm, sizeof (okm));
+      hexof(okm, sizeof (okm), ref);
+      hexof(ob[q], sizeof (okm), bo);
+      fail += check("hkdf-rmd320 batch", bo, ref);
+    }
+  }
+
+  /* Batch HMAC against one message at a time */
+  for (n = 1; n <= 19; n += 9) {
+    rmd160hkeymacn(k160, n, id, il, ob[0]);
+    for (q = 0; q < n; ++q) {
+      rmd160hkeymac(k160, id[q], il[q], h160);
+      hexof(h160, RMD160_SZ, ref160);
+      hexof(ob[0] + q * RMD160_SZ, RMD160_SZ, b160);
+      fail += check("hmac-rmd160 batch", b160, ref160);
+    }
+    rmd320hkeymacn(k320, n, id, il, ob[0]);
+    for (q = 0; q < n; ++q) {
+      rmd320hkeymac(k320, id[q], il[q], h320);
+      hexof(h320, RMD320_SZ, ref320);
+      hexof(ob[0] + q * RMD320_SZ, RMD320_SZ, b320);
+      fail += check("hmac-rmd320 batch", b320, ref320);
+    }
+  }
+
+  /* Streaming HMAC: the t6 message fed in uneven pieces */
+  if (!(m160 = malloc(rmd160hmactsize())) || !(m320 = malloc(rmd320hmactsize()))) {
+    fprintf(stderr, "FAIL: malloc(hmactsize)\n");
+    return (1);
+  }
+  for (q = 0; q < sizeof (Chunks) / sizeof (Chunks[0]); ++q) {
+    msglen = sizeof (Hd6) - 1;
+    rmd160hmacinit(m160, Hk6, sizeof (Hk6));
+    rmd320hmacstart(m320, k320);
+    for (off = 0; off < msglen; off += n) {
+      n = Chunks[q];
+      if (off + n > msglen)
+        n = msglen - off;
+      rmd160hmacupdate(m160, (const unsigned char *)Hd6 + off, n);
+      rmd320hmacupdate(m320, (const unsigned char *)Hd6 + off, n);
+    }
+    rmd160hmacfinal(m160, h160);
+    rmd320hmacfinal(m320, h320);
+    hexof(h160, RMD160_SZ, b160);
+    hexof(h320, RMD320_SZ, b320);
+    fail += check("hmac-rmd160 stream", b160, "6466ca07ac5eac29e1bd523e5ada7605b791fd8b");
+    fail += check("hmac-rmd320 stream", b320, "a61c1123c1a23ffdd9af5fb28b62b95f989876ac322452f5e4f4470c25182ef4816aaec7f0377167");
+  }
+  free(m160);
+  free(m320);
+  free(k160);
+  free(k320);
+
+  /* Tree hash: five leaves, the last short, against the definition */
+  if (!(t160 = malloc(rmd160treetsize())) || !(t320 = malloc(rmd320treetsize()))
+   || !(big = malloc(4 * RMD160_CHUNK + 5))) {
+    fprintf(stderr, "FAIL: malloc(treetsize)\n");
+    return (1);
+  }
+  for (k = 0; k < 4 * RMD160_CHUNK + 5; ++k)
+    big[k] = (unsigned char)(k * 7 + k / 251);
+  for (q = 0; q < 5; ++q)
+    tree160(c160, 0x00, big + q * RMD160_CHUNK, q < 4 ? RMD160_CHUNK : 5, 0, tl[q]);
+  tree160(c160, 0x01, tl[0], RMD160_SZ, tl[1], tl[0]);
+  tree160(c160, 0x01, tl[2], RMD160_SZ, tl[3], tl[2]);
+  tree160(c160, 0x01, tl[0], RMD160_SZ, tl[2], tl[0]);
+  tree160(c160, 0x01, tl[0], RMD160_SZ, tl[4], tl[0]);
+  hexof(tl[0], RMD160_SZ, ref160);
+  rmd160tree(big, 4 * RMD160_CHUNK + 5, h160);
+  hexof(h160, RMD160_SZ, b160);
+  fail += check("tree-rmd160", b160, ref160);
+  rmd160treeinit(t160);
+  for (off = 0, n = 1; off < 4 * RMD160_CHUNK + 5; off += n, n = n * 3 + 1) {
+    if (n > 4 * RMD160_CHUNK + 5 - off)
+      n = 4 * RMD160_CHUNK + 5 - off;
+    rmd160treeupdate(t160, big + off, n);
+  }
+  rmd160treefinal(t160, h160);
+  hexof(h160, RMD160_SZ, b160);
+  fail += check("tree-rmd160 stream", b160, ref160);
+  for (q = 0; q < 5; ++q) {
+    bd[q] = big + q * RMD160_CHUNK;
+    bl[q] = q < 4 ? RMD160_CHUNK : 5;
+  }
+  rmd160treeleafn(5, bd, bl, hb);
+  rmd160treeroot(hb, 5, h160);
+  hexof(h160, RMD160_SZ, b160);
+  fail += check("tree-rmd160 leaves", b160, ref160);
+  for (q = 0; q < 2; ++q)
+    tree160(c160, 0x00, big + q * RMD160_CHUNK, RMD160_CHUNK, 0, tl[q]);
+  tree160(c160, 0x01, tl[0], RMD160_SZ, tl[1], tl[0]);
+  hexof(tl[0], RMD160_SZ, ref160);
+  rmd160tree(big, 2 * RMD160_CHUNK, h160);
+  hexof(h160, RMD160_SZ, b160);
+  fail += check("tree-rmd160 whole chunks", b160, ref160);
+  rmd160tree(big, 0, h160);
+  hexof(h160, RMD160_SZ, b160);
+  fail += check("tree-rmd160 empty", b160, "9b8ccc2f374ae313a914763cc9cdfb47bfe1c229");
+
+  for (q = 0; q < 5; ++q)
+    tree320(c320, 0x00, big + q * RMD320_CHUNK, q < 4 ? RMD320_CHUNK : 5, 0, tl[q]);
+  tree320(c320, 0x01, tl[0], RMD320_SZ, tl[1], tl[0]);
+  tree320(c320, 0x01, tl[2], RMD320_SZ, tl[3], tl[2]);
+  tree320(c320, 0x01, tl[0], RMD320_SZ, tl[2], tl[0]);
+  tree320(c320, 0x01, tl[0], RMD320_SZ, tl[4], tl[0]);
+  hexof(tl[0], RMD320_SZ, ref320);
+  rmd320tree(big, 4 * RMD320_CHUNK + 5, h320);
+  hexof(h320, RMD320_SZ, b320);
+  fail += check("tree-rmd320", b320, ref320);
+  rmd320treeinit(t320);
+  for (off = 0, n = 1; off < 4 * RMD320_CHUNK + 5; off += n, n = n * 3 + 1) {
+    if (n > 4 * RMD320_CHUNK + 5 - off)
+      n = 4 * RMD320_CHUNK + 5 - off;
+    rmd320treeupdate(t320, big + off, n);
+  }
+  rmd320treefinal(t320, h320);
+  hexof(h320, RMD320_SZ, b320);
+  fail += check("tree-rmd320 stream", b320, ref320);
+  rmd320treeleafn(5, bd, bl, hb);
+  rmd320treeroot(hb, 5, h320);
+  hexof(h320, RMD320_SZ, b320);
+  fail += check("tree-rmd320 leaves", b320, ref320);
+
+  /* Merkle tree: root, path updates, proofs and a copied region */
+  for (n = 1; n <= 19; n += 6) {
+    void *mr;
+    void *mc;
+
+    if (!(mr = malloc(rmd160mtsize(n))) || !(mc = malloc(rmd160mtsize(n)))) {
+      fprintf(stderr, "FAIL: malloc(mtsize)\n");
+      return (1);
+    }
+    mt = rmd160mtinit(mr, n);
+    for (q = 0; q < n; ++q) {
+      id[q] = big + q * 1000;
+      il[q] = 1000 + q;
+    }
+    rmd160mtload(mt, 0, n, id, il);
+    rmd160mtcommit(mt);
+    rmd160treeleafn(n, id, il, mb);
+    rmd160treeroot(mb, n, h160);
+    hexof(h160, RMD160_SZ, ref160);
+    rmd160mtroot(mt, h160);
+    hexof(h160, RMD160_SZ, b160);
+    fail += check("merkle-rmd160 root", b160, ref160);
+    il[n / 2] = 7;
+    rmd160mtset(mt, n / 2, id[n / 2], il[n / 2]);
+    rmd160treeleafn(n, id, il, mb);
+    rmd160treeroot(mb, n, h160);
+    hexof(h160, RMD160_SZ, ref160);
+    rmd160mtroot(mt, h160);
+    hexof(h160, RMD160_SZ, b160);
+    fail += check("merkle-rmd160 update", b160, ref160);
+    memcpy(mc, mr, rmd160mtsize(n));
+    fail += !rmd160mtopen(mc, rmd160mtsize(n)) || rmd160mtopen(mc, rmd160mtsize(n) - 1)
+     || rmd160mtleaves(rmd160mtopen(mc, rmd160mtsize(n))) != n;
+    for (q = 0; q < n; ++q) {
+      rmd160mtleaf(rmd160mtopen(mc, rmd160mtsize(n)), q, h320);
+      k = rmd160mtproof(rmd160mtopen(mc, rmd160mtsize(n)), q, pf);
+      fail += rmd160mtverify(n, q, h320, pf, k, h160) != 0;
+      if (k) {
+        pf[0] ^= 1;
+        fail += rmd160mtverify(n, q, h320, pf, k, h160) == 0;
+      }
+      fail += rmd160mtverify(n, q ^ 1, h320, pf, k, h160) == 0 && n > 1;
+    }
+    free(mc);
+    free(mr);
+  }
+  memset(mf, 0, sizeof (mf)); /* a forged leaf count whose size wraps */
+  memcpy(mf, "RMD160MT", 8);
+  mf[8] = 0x01;
+  mf[15] = 0x20;
+  fail += rmd160mtopen(mf, sizeof (mf)) != 0;
+
+  /* Fixed length messages against the context functions */
+  for (q = 0; q < sizeof (Fixl) / sizeof (Fixl[0]); ++q) {
+    rmd160init(c160);
+    rmd160update(c160, (const unsigned char *)Msg, Fixl[q]);
+    rmd160final(c160, h160);
+    hexof(h160, RMD160_SZ, ref160);
+    Fix160[q]((const unsigned char *)Msg, h160);
+    hexof(h160, RMD160_SZ, b160);
+    fail += check("fix-rmd160", b160, ref160);
+    rmd320init(c320);
+    rmd320update(c320, (const unsigned char *)Msg, Fixl[q]);
+    rmd320final(c320, h320);
+    hexof(h320, RMD320_SZ, ref320);
+    Fix320[q]((const unsigned char *)Msg, h320);
+    hexof(h320, RMD320_SZ, b320);
+    fail += check("fix-rmd320", b320, ref320);
+    rmd160fixn(19, Fixl[q], big, ob[0]);
+    rmd320fixn(19, Fixl[q], big, ob[0] + 19 * RMD160_SZ);
+    for (k = 0; k < 19; ++k) {
+      Fix160[q](big + k * Fixl[q], h160);
+      hexof(h160, RMD160_SZ, ref160);
+      hexof(ob[0] + k * RMD160_SZ, RMD160_SZ, b160);
+      fail += check("fix-rmd160 batch", b160, ref160);
+      Fix320[q](big + k * Fixl[q], h320);
+      hexof(h320, RMD320_SZ, ref320);
+      hexof(ob[0] + 19 * RMD160_SZ + k * RMD320_SZ, RMD320_SZ, b320);
+      fail += check("fix-rmd320 batch", b320, ref320);
+    }
+  }
+
+  /* Digest index: repeats dropped, every digest found, none other, batch agrees */
+  for (k = 0; k <= 8; k += 4) {
+    unsigned char *ix;
+    unsigned char *ih;
+    unsigned char ir[600];
+    rmd160ix_t *x;
+    size_t z;
+    int e;
+
+    if (!(ix = malloc(rmd160ixsize(400, k))) || !(ih = malloc(600 * RMD160_SZ))) {
+      fprintf(stderr, "FAIL: malloc(ixsize)\n");
+      return (1);
+    }
+    for (q = 0; q < 600; ++q)
+      rmd160((const unsigned char *)&q, sizeof (q), ih + q * RMD160_SZ);
+    memcpy(ix + rmd160ixsize(0, k), ih, 300 * RMD160_SZ);
+    memcpy(ix + rmd160ixsize(300, k), ih, 100 * RMD160_SZ);
+    z = rmd160ixbuild(ix, ix + rmd160ixsize(0, k), 400, k);
+    fail += e = z != rmd160ixsize(300, k) || rmd160ixopen(ix, z - 1) || !(x = rmd160ixopen(ix, z))
+     || rmd160ixcount(x) != 300;
+    if (!e) {
+      for (q = 0; q < 600; ++q)
+        fail += rmd160ixfind(x, ih + q * RMD160_SZ) != (q < 300);
+      fail += rmd160ixfindn(x, 600, ih, ir) != 300;
+      for (q = 0; q < 600; ++q)
+        fail += ir[q] != (q < 300);
+    }
+    free(ih);
+    free(ix);
+  }
+
+  /* Content defined chunks: bounds, digests, the same cuts streamed or shifted, the table */
+  {
+    unsigned long long x;
+    unsigned char *cd;
+    unsigned char *ch;
+    unsigned int *cl;
+    unsigned int *cs;
+    rmd160cdix_t *ct;
+    size_t cz;
+    size_t o;
+    size_t v;
+    unsigned int cn;
+    unsigned int sn;
+    unsigned int e;
+
+    cz = 1U << 20;
+    if (!(cd = malloc(cz)) || !(ch = malloc((cz / RMD160_CDMIN + 1) * RMD320_SZ))
+     || !(cl = malloc((cz / RMD160_CDMIN + 1) * sizeof (*cl))) || !(cs = malloc((cz / RMD160_CDMIN + 1) * sizeof (*cs)))
+     || !(ct = malloc(rmd160cdixtsize(cz / RMD160_CDMIN + 1)))) {
+      fprintf(stderr, "FAIL: malloc(cd)\n");
+      return (1);
+    }
+    for (x = 88172645463325252ULL, o = 0; o < cz; ++o) {
+      x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+      cd[o] = (unsigned char)(x >> 32);
+    }
+    cn = rmd160cd(cd, cz, 1, cz / RMD160_CDMIN + 1, cl, ch);
+    for (e = 0, o = 0, q = 0; q < cn; o += cl[q++]) {
+      e += cl[q] > RMD160_CDMAX || (cl[q] < RMD160_CDMIN && q + 1 < cn);
+      rmd160(cd + o, cl[q], h160);
+      e += memcmp(h160, ch + q * RMD160_SZ, RMD160_SZ) != 0;
+    }
+    fail += e += o != cz || cn < cz / RMD160_CDAVG / 2;
+    if (e)
+      fprintf(stderr, "FAIL: cd-rmd160 chunks\n");
+    for (e = 0, o = 0, sn = 0; o < cz; sn += k)
+      for (k = rmd160cd(cd + o, cz - o < 100000 ? cz - o : 100000, cz - o <= 100000, cz, cs + sn, ch), q = 0; q < k; ++q)
+        o += cs[sn + q];
+    for (fail += e = sn != cn, q = 0; !e && q < cn; ++q)
+      fail += e = cs[q] != cl[q];
+    if (e)
+      fprintf(stderr, "FAIL: cd-rmd160 streamed\n");
+    sn = rmd160cd(cd + 1000, cz - 1000, 1, cz, cs, ch);
+    for (e = 0, q = 0; q < cn / 2; ++q)
+      e += cs[sn - 1 - q] != cl[cn - 1 - q];
+    fail += e += sn < cn / 2;
+    if (e)
+      fprintf(stderr, "FAIL: cd-rmd160 shifted\n");
+    cn = rmd160cd(cd, cz, 1, cz, cl, ch);
+    rmd160cdixinit(ct, cn);
+    for (e = 0, q = 0; q < cn; ++q)
+      e += rmd160cdixput(ct, ch + q * RMD160_SZ, q, 0) != 1;
+    for (q = 0; q < cn; ++q)
+      e += rmd160cdixput(ct, ch + q * RMD160_SZ, cn + q, &v) != 0 || v != q
+       || rmd160cdixget(ct, ch + q * RMD160_SZ, &v) != 1 || v != q;
+    rmd160((const unsigned char *)Msg, 10, h160);
+    e += rmd160cdixget(ct, h160, &v) != 0 || rmd160cdixput(ct, h160, 0, 0) != -1 || rmd160cdixcount(ct) != cn;
+    fail += e;
+    if (e)
+      fprintf(stderr, "FAIL: cd-rmd160 table\n");
+    for (q = 0; q < 3; ++q) {
+      bd[q] = cd + q * 1000;
+      bl[q] = cl[q];
+    }
+    rmd320n(3, bd, bl, ch);
+    for (q = 0; q < 3; ++q) {
+      rmd320(bd[q], bl[q], h320);
+      hexof(h320, RMD320_SZ, ref320);
+      hexof(ch + q * RMD320_SZ, RMD320_SZ, b320);
+      fail += check("rmd320n", b320, ref320);
+    }
+    free(ct);
+    free(cs);
+    free(cl);
+    free(ch);
+    free(cd);
+  }
+
+  /* Exported state: resumed at every split, malformed states refused */
+  for (q = 0; q <= Svec[7].inlen; q += 13) {
+    unsigned char st[RMD320_STATESZ];
+    unsigned long long sn;
+
+    rmd160init(c160);
+    rmd160update(c160, (const unsigned char *)Svec[7].in, q);
+    rmd160export(c160, st);
+    memset(c160, 0xa5, rmd160tsize());
+    fail += rmd160import(c160, st, &sn) != 0 || sn != q;
+    rmd160update(c160, (const unsigned char *)Svec[7].in + q, Svec[7].inlen - q);
+    rmd160final(c160, h160);
+    hexof(h160, RMD160_SZ, b160);
+    fail += check("state-rmd160", b160, Svec[7].h160);
+    st[6] ^= 1;
+    fail += rmd160import(c160, st, 0) != -1;
+    st[6] ^= 1;
+    st[RMD160_STATESZ - 1] ^= 1;
+    fail += rmd160import(c160, st, 0) != -1;
+    rmd320init(c320);
+    rmd320update(c320, (const unsigned char *)Svec[7].in, q);
+    rmd320export(c320, st);
+    memset(c320, 0xa5, rmd320tsize());
+    fail += rmd320import(c320, st, &sn) != 0 || sn != q;
+    rmd320update(c320, (const unsigned char *)Svec[7].in + q, Svec[7].inlen - q);
+    rmd320final(c320, h320);
+    hexof(h320, RMD320_SZ, b320);
+    fail += check("state-rmd320", b320, Svec[7].h320);
+    st[7] = 64;
+    fail += rmd320import(c320, st, 0) != -1;
+  }
+
+  /* Prefixed hashing: against the whole message, batch against single, a copied context */
+  for (n = 0; n < sizeof (Pfxl) / sizeof (Pfxl[0]); ++n) {
+    rmd160pfx_t *p160;
+    rmd320pfx_t *p320;
+
+    k = Pfxl[n];
+    if (!(p160 = malloc(rmd160pfxtsize())) || !(p320 = malloc(rmd320pfxtsize()))) {
+      fprintf(stderr, "FAIL: malloc(pfxtsize)\n");
+      return (1);
+    }
+    rmd160pfxinit(p160, big, k);
+    for (q = 0; q < sizeof (Lanes) / sizeof (Lanes[0]); ++q) {
+      bd[q] = big + 1000 + q;
+      bl[q] = Lanes[q];
+    }
+    rmd160pfxn(p160, 16, bd, bl, hb);
+    for (q = 0; q < 16; ++q) {
+      rmd160init(c160);
+      rmd160update(c160, big, k);
+      rmd160update(c160, bd[q], bl[q]);
+      rmd160final(c160, h160);
+      hexof(h160, RMD160_SZ, ref160);
+      rmd160pfx(p160, bd[q], bl[q], h160);
+      hexof(h160, RMD160_SZ, b160);
+      fail += check("pfx-rmd160", b160, ref160);
+      hexof(hb + q * RMD160_SZ, RMD160_SZ, b160);
+      fail += check("pfx-rmd160 batch", b160, ref160);
+    }
+    rmd320pfxinit(p320, big, k);
+    rmd320pfxn(p320, 16, bd, bl, hb);
+    for (q = 0; q < 16; ++q) {
+      rmd320pfxstart(p320, c320);
+      rmd320update(c320, bd[q], bl[q]);
+      rmd320final(c320, h320);
+      hexof(h320, RMD320_SZ, ref320);
+      hexof(hb + q * RMD320_SZ, RMD320_SZ, b320);
+      fail += check("pfx-rmd320 batch", b320, ref320);
+    }
+    free(p320);
+    free(p160);
+  }
+  rmd160init(c160);
+  rmd160update(c160, (const unsigned char *)Svec[7].in, 30);
+  {
+    rmd160_t *cc;
+
+    if (!(cc = malloc(rmd160tsize()))) {
+      fprintf(stderr, "FAIL: malloc(tsize)\n");
+      return (1);
+    }
+    rmd160copy(cc, c160);
+    rmd160update(c160, (const unsigned char *)Svec[7].in + 30, Svec[7].inlen - 30);
+    rmd160final(c160, h160);
+    hexof(h160, RMD160_SZ, b160);
+    fail += check("copy-rmd160 original", b160, Svec[7].h160);
+    rmd160update(cc, (const unsigned char *)Svec[7].in + 30, Svec[7].inlen - 30);
+    rmd160final(cc, h160);
+    hexof(h160, RMD160_SZ, b160);
+    fail += check("copy-rmd160 copy", b160, Svec[7].h160);
+    free(cc);
+  }
+  free(big);
+  free(t320);
+  free(t160);
+
   free(c160);
   free(c320);
   if (fail) {
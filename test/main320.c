@@ -1,30 +1,560 @@
+#define _DEFAULT_SOURCE /* scandir, getline, madvise */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "rmd320.h"
+#include "uring.h"
 
-int
-main(
-  void
-){
+/*
+ * rmd320 [-t|-k] [-j threads] [path ...]
+ *  With no path, hash standard input and write only the digest.
+ *  Otherwise write "digest  path" for every file, descending into directories.
+ * rmd320 -c [-t|-k] [-j threads] [manifest ...]
+ *  Verify the "digest  path" lines of each manifest (standard input if none).
+ * Files are hashed concurrently, one worker per online processor unless -j,
+ * and reported in the order given.
+ * -t computes the tree hash (rmd320tree) instead, the workers sharing
+ * the chunks of a regular file sixteen at a time.
+ * Each worker keeps DEPTH reads of regular files in flight on an io_uring;
+ * without one, regular files are mapped and everything else read().
+ * -k keeps the state after each regular file in "path.rmd320state" and
+ * starts from it next time, hashing only what was appended since;
+ * only for files that are appended to and never rewritten.
+ */
+
+#define BUFSZ (1024 * 1024) /* read() size when the input cannot be mapped */
+#define HX (2 * RMD320_SZ)  /* hex digest length */
+#define DEPTH 8             /* reads in flight per worker */
+#define CHUNK (256 * 1024)  /* bytes per read in flight */
+#define GROUP 16            /* tree leaves per unit of work */
+#define KEEP ".rmd320state"  /* checkpoint suffix */
+
+struct job {
+  char *p;           /* path, "-" is standard input */
+  char *e;           /* expected hex digest when checking */
+  char h[HX];        /* hex digest */
+  int s;             /* -1 pending, 0 hashed, else errno */
+  int r;             /* first error of a unit */
+  size_t g;          /* units of work, GROUP leaves each when tree hashing */
+  size_t gc;         /* units claimed */
+  size_t gd;         /* units done */
+  size_t nl;         /* tree leaves, 0 when streamed */
+  off_t z;           /* bytes in the leaves */
+  unsigned char *lv; /* leaf digests */
+};
+
+struct work {
+  pthread_t t;
   rmd320_t *c;
+  rmd320tree_t *tc;
+  void *b;
+  void *lb; /* GROUP chunks for tree leaves */
+  uring_t *u;
+};
+
+static const char *Me = "rmd320";
+static struct job *J;
+static unsigned int Jn;   /* jobs */
+static unsigned int Ja;   /* jobs allocated */
+static unsigned int Next; /* next job to hash */
+static unsigned int Show; /* next job to report */
+static int Check;
+static int Tree;
+static int Keep;
+static int Bare;
+static int Bad;
+static pthread_mutex_t M = PTHREAD_MUTEX_INITIALIZER;
+
+static void
+update(
+  void *c
+ ,const unsigned char *d
+ ,size_t l
+){
+  rmd320updatez(c, d, l);
+}
+
+static void
+treeupdate(
+  void *c
+ ,const unsigned char *d
+ ,size_t l
+){
+  rmd320treeupdate(c, d, l);
+}
+
+/* hash bytes o to z of a regular file in one call, 0 if it cannot be mapped */
+static int
+mapped(
+  rmd320_t *c
+ ,int f
+ ,off_t o
+ ,off_t z
+){
+  void *m;
+
+  if ((m = mmap(0, (size_t)z, PROT_READ, MAP_PRIVATE, f, 0)) == MAP_FAILED)
+    return (0);
+#ifdef MADV_SEQUENTIAL
+  madvise(m, (size_t)z, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_HUGEPAGE
+  madvise(m, (size_t)z, MADV_HUGEPAGE);
+#endif
+  rmd320updatez(c, (const unsigned char *)m + o, (size_t)(z - o));
+  munmap(m, (size_t)z);
+  return (1);
+}
+
+/* hash a pipe (or anything else) through a large page aligned buffer */
+static int
+streamed(
+  void (*u)(void *, const unsigned char *, size_t)
+ ,void *c
+ ,void *b
+ ,int f
+){
+  ssize_t i;
+
+  while ((i = read(f, b, BUFSZ)) != 0)
+    if (i > 0)
+      u(c, b, (size_t)i);
+    else if (errno != EINTR)
+      return (errno);
+  return (0);
+}
+
+/* start c from the checkpoint of a file of z bytes, returns the bytes it covers */
+static off_t
+resume(
+  rmd320_t *c
+ ,const char *p
+ ,off_t z
+){
+  unsigned char s[RMD320_STATESZ];
+  unsigned long long n;
+  char *k;
+  ssize_t r;
+  int f;
+
+  r = -1;
+  if ((k = malloc(strlen(p) + sizeof (KEEP)))) {
+    sprintf(k, "%s%s", p, KEEP);
+    if ((f = open(k, O_RDONLY)) >= 0) {
+      r = read(f, s, sizeof (s));
+      close(f);
+    }
+    free(k);
+  }
+  if (r != sizeof (s) || rmd320import(c, s, &n) || n > (unsigned long long)z) {
+    rmd320init(c); /* none, or the file is not what it was */
+    return (0);
+  }
+  return ((off_t)n);
+}
+
+/* write the checkpoint of a file, replacing any earlier one at once */
+static void
+keep(
+  const rmd320_t *c
+ ,const char *p
+){
+  unsigned char s[RMD320_STATESZ];
+  char *k;
+  char *t;
+  int f;
+  int r;
+
+  rmd320export(c, s);
+  if (!(k = malloc(2 * (strlen(p) + sizeof (KEEP)) + 1))) {
+    fprintf(stderr, "%s: out of memory\n", Me);
+    return;
+  }
+  t = k + strlen(p) + sizeof (KEEP);
+  sprintf(k, "%s%s", p, KEEP);
+  sprintf(t, "%s%s~", p, KEEP);
+  r = (f = open(t, O_WRONLY | O_CREAT | O_TRUNC, 0644)) >= 0 && write(f, s, sizeof (s)) == sizeof (s);
+  if (f >= 0 && close(f))
+    r = 0;
+  if (!r || rename(t, k)) {
+    fprintf(stderr, "%s: %s: %s\n", Me, k, strerror(errno));
+    unlink(t);
+  }
+  free(k);
+}
+
+/* hex digest of a path, 0 or errno */
+static int
+digest(
+  struct work *w
+ ,const char *p
+ ,char *x
+){
+  unsigned char h[RMD320_SZ];
+  unsigned char st[RMD320_STATESZ]; /* c before the ring, to start over from */
+  struct stat s;
+  off_t o;
+  int f;
+  int k;
+  int e;
+
+  k = 0;
+  if (!strcmp(p, "-"))
+    f = 0;
+  else if ((f = open(p, O_RDONLY)) < 0)
+    return (errno);
+  if (Tree) {
+    rmd320treeinit(w->tc);
+    e = streamed(treeupdate, w->tc, w->b, f);
+  } else {
+    rmd320init(w->c);
+    if (fstat(f, &s) || !S_ISREG(s.st_mode) || s.st_size <= 0
+     || (o = lseek(f, 0, SEEK_CUR)) < 0 || o > s.st_size)
+      e = streamed(update, w->c, w->b, f);
+    else {
+      if ((k = Keep && f) && (o = resume(w->c, p, s.st_size)) == s.st_size)
+        e = 0;
+      else {
+        e = -1;
+        if (w->u) {
+          rmd320export(w->c, st);
+          if ((e = uringread(w->u, f, o, s.st_size - o, update, w->c)) < 0) {
+            uringclose(w->u); /* the ring failed: drop it, and start the file over without */
+            w->u = 0;
+            rmd320import(w->c, st, 0);
+          }
+        }
+        if (e < 0)
+          e = mapped(w->c, f, o, s.st_size) ? 0
+            : lseek(f, o, SEEK_SET) < 0 ? errno : streamed(update, w->c, w->b, f);
+      }
+    }
+  }
+  if (f)
+    close(f);
+  if (e)
+    return (e);
+  if (k)
+    keep(w->c, p);
+  if (Tree)
+    rmd320treefinal(w->tc, h);
+  else
+    rmd320final(w->c, h);
+  rmd320hex(h, x);
+  return (0);
+}
+
+/* tree leaves of unit k of a regular file, 0 or errno */
+static int
+leaves(
+  struct work *w
+ ,struct job *j
+ ,size_t k
+){
+  const unsigned char *q[GROUP];
+  unsigned int ql[GROUP];
+  size_t m;
+  size_t n;
   size_t i;
-  unsigned char h[40];
-  unsigned char b[80];
-
-  if (!(c = malloc(rmd320tsize())))
-    return (1);
-  rmd320init(c);
-  while ((i = fread(b, 1, sizeof (b), stdin)) == sizeof (b))
-    rmd320update(c, b, i);
-  if (ferror(stdin)) {
-    free(c);
-    return (1);
-  }
-  if (i > 0)
-    rmd320update(c, b, i);
-  rmd320final(c, h);
-  free(c);
-  rmd320hex(h, (char *)b);
-  printf("%.80s\n", (char *)b);
+  ssize_t r;
+  off_t o;
+  int f;
+
+  o = (off_t)k * GROUP * RMD320_CHUNK;
+  m = j->z - o < (off_t)GROUP * RMD320_CHUNK ? (size_t)(j->z - o) : (size_t)GROUP * RMD320_CHUNK;
+  if ((f = open(j->p, O_RDONLY)) < 0)
+    return (errno);
+  for (i = 0; i < m; i += (size_t)r)
+    if ((r = pread(f, (unsigned char *)w->lb + i, m - i, o + (off_t)i)) <= 0) {
+      if (r < 0 && errno == EINTR) {
+        r = 0;
+        continue;
+      }
+      r = r ? errno : EIO; /* the file shrank */
+      close(f);
+      return ((int)r);
+    }
+  close(f);
+  n = (m + RMD320_CHUNK - 1) / RMD320_CHUNK;
+  for (i = 0; i < n; ++i) {
+    q[i] = (unsigned char *)w->lb + i * RMD320_CHUNK;
+    ql[i] = i + 1 < n ? RMD320_CHUNK : (unsigned int)(m - i * RMD320_CHUNK);
+  }
+  rmd320treeleafn((unsigned int)n, q, ql, j->lv + k * GROUP * RMD320_SZ);
+  return (0);
+}
+
+static void
+show(
+  struct job *j
+){
+  if (j->s) {
+    fprintf(stderr, "%s: %s: %s\n", Me, j->p, strerror(j->s));
+    if (Check)
+      printf("%s: FAILED open or read\n", j->p);
+    Bad = 1;
+  } else if (Check) {
+    if (strncasecmp(j->h, j->e, HX)) {
+      printf("%s: FAILED\n", j->p);
+      Bad = 1;
+    } else
+      printf("%s: OK\n", j->p);
+  } else if (Bare)
+    printf("%.*s\n", HX, j->h);
+  else
+    printf("%.*s  %s\n", HX, j->h, j->p);
+  free(j->p);
+  free(j->e);
+  free(j->lv);
+}
+
+static void *
+worker(
+  void *a
+){
+  unsigned char h[RMD320_SZ];
+  struct work *w;
+  struct job *j;
+  size_t k;
+  int r;
+
+  w = a;
+  for (;;) {
+    pthread_mutex_lock(&M);
+    if (Next == Jn) {
+      pthread_mutex_unlock(&M);
+      break;
+    }
+    j = J + Next;
+    if ((k = j->gc++) + 1 == j->g)
+      ++Next;
+    pthread_mutex_unlock(&M);
+    r = j->nl ? leaves(w, j, k) : digest(w, j->p, j->h);
+    pthread_mutex_lock(&M);
+    if (r && !j->r)
+      j->r = r;
+    k = ++j->gd;
+    pthread_mutex_unlock(&M);
+    if (k < j->g)
+      continue;
+    /* the last unit of a job, every other one is done */
+    if (j->nl && !j->r) {
+      rmd320treeroot(j->lv, j->nl, h);
+      rmd320hex(h, j->h);
+    }
+    pthread_mutex_lock(&M);
+    j->s = j->r;
+    while (Show < Jn && J[Show].s >= 0)
+      show(J + Show++);
+    pthread_mutex_unlock(&M);
+  }
   return (0);
 }
+
+static void
+add(
+  const char *p
+ ,const char *e
+){
+  struct job *t;
+
+  if (Jn == Ja) {
+    if (!(t = realloc(J, (Ja ? Ja * 2 : 64) * sizeof (*J)))) {
+      fprintf(stderr, "%s: out of memory\n", Me);
+      exit(2);
+    }
+    J = t;
+    Ja = Ja ? Ja * 2 : 64;
+  }
+  J[Jn].p = strdup(p);
+  J[Jn].e = e ? strdup(e) : 0;
+  J[Jn].s = -1;
+  J[Jn].r = 0;
+  J[Jn].g = 1;
+  J[Jn].gc = J[Jn].gd = 0;
+  J[Jn].nl = 0;
+  J[Jn].z = 0;
+  J[Jn].lv = 0;
+  if (!J[Jn].p || (e && !J[Jn].e)) {
+    fprintf(stderr, "%s: out of memory\n", Me);
+    exit(2);
+  }
+  ++Jn;
+}
+
+/* add a path, or the files below it in name order */
+static void
+walk(
+  const char *p
+){
+  struct dirent **d;
+  struct stat s;
+  char *q;
+  size_t l;
+  int n;
+  int i;
+
+  if (!strcmp(p, "-") || lstat(p, &s) || !S_ISDIR(s.st_mode)) {
+    add(p, 0);
+    return;
+  }
+  if ((n = scandir(p, &d, 0, alphasort)) < 0) {
+    fprintf(stderr, "%s: %s: %s\n", Me, p, strerror(errno));
+    Bad = 1;
+    return;
+  }
+  l = strlen(p);
+  for (i = 0; i < n; ++i) {
+    if (strcmp(d[i]->d_name, ".") && strcmp(d[i]->d_name, "..")
+     && (!Keep || (strlen(d[i]->d_name) < sizeof (KEEP) - 1
+      || strcmp(d[i]->d_name + strlen(d[i]->d_name) - sizeof (KEEP) + 1, KEEP)))
+     && (q = malloc(l + strlen(d[i]->d_name) + 2))) {
+      sprintf(q, "%s%s%s", p, l && p[l - 1] == '/' ? "" : "/", d[i]->d_name);
+      walk(q);
+      free(q);
+    }
+    free(d[i]);
+  }
+  free(d);
+}
+
+/* add the "digest  path" (or "digest *path") lines of a manifest */
+static void
+manifest(
+  const char *p
+){
+  unsigned char h[RMD320_SZ];
+  FILE *f;
+  char *b;
+  size_t a;
+  ssize_t l;
+  unsigned int n;
+
+  if (!strcmp(p, "-"))
+    f = stdin;
+  else if (!(f = fopen(p, "r"))) {
+    fprintf(stderr, "%s: %s: %s\n", Me, p, strerror(errno));
+    Bad = 1;
+    return;
+  }
+  b = 0;
+  a = 0;
+  for (n = 1; (l = getline(&b, &a, f)) > 0; ++n) {
+    while (l && (b[l - 1] == '\n' || b[l - 1] == '\r'))
+      b[--l] = '\0';
+    if (l < HX + 3 || rmd320unhex(b, h) >= 0 || b[HX] != ' ' || (b[HX + 1] != ' ' && b[HX + 1] != '*')) {
+      fprintf(stderr, "%s: %s: %u: improperly formatted line\n", Me, p, n);
+      Bad = 1;
+      continue;
+    }
+    b[HX] = '\0';
+    add(b + HX + 2, b);
+  }
+  free(b);
+  if (f != stdin)
+    fclose(f);
+}
+
+int
+main(
+  int argc
+ ,char *argv[]
+){
+  struct work *w;
+  size_t g;
+  long t;
+  unsigned int n;
+  unsigned int i;
+  int a;
+
+  t = 0;
+  g = 0;
+  for (a = 1; a < argc && argv[a][0] == '-' && argv[a][1]; ++a)
+    if (!strcmp(argv[a], "--")) {
+      ++a;
+      break;
+    } else if (!strcmp(argv[a], "-c") || !strcmp(argv[a], "--check"))
+      Check = 1;
+    else if (!strcmp(argv[a], "-t") || !strcmp(argv[a], "--tree"))
+      Tree = 1;
+    else if (!strcmp(argv[a], "-k") || !strcmp(argv[a], "--keep"))
+      Keep = 1;
+    else if (!strcmp(argv[a], "-j") && a + 1 < argc && (t = strtol(argv[++a], 0, 10)) > 0)
+      ;
+    else {
+      fprintf(stderr, "usage: %s [-c] [-t|-k] [-j threads] [path ...]\n", Me);
+      return (2);
+    }
+  if (Tree && Keep) {
+    fprintf(stderr, "usage: %s [-c] [-t|-k] [-j threads] [path ...]\n", Me);
+    return (2);
+  }
+  if (a == argc) {
+    Bare = !Check;
+    if (Check)
+      manifest("-");
+    else
+      add("-", 0);
+  }
+  for (; a < argc; ++a)
+    if (Check)
+      manifest(argv[a]);
+    else
+      walk(argv[a]);
+  for (i = 0; Tree && i < Jn; ++i) { /* split regular files into units of leaves */
+    struct stat s;
+
+    if (strcmp(J[i].p, "-") && !stat(J[i].p, &s) && S_ISREG(s.st_mode) && s.st_size > 0) {
+      J[i].z = s.st_size;
+      J[i].nl = (size_t)((s.st_size - 1) / RMD320_CHUNK + 1);
+      J[i].g = (J[i].nl - 1) / GROUP + 1;
+      if (!(J[i].lv = malloc(J[i].nl * RMD320_SZ))) {
+        fprintf(stderr, "%s: out of memory\n", Me);
+        return (2);
+      }
+      g += J[i].g - 1;
+    }
+  }
+  if (t <= 0 && (t = sysconf(_SC_NPROCESSORS_ONLN)) <= 0)
+    t = 1;
+  n = (unsigned long)t < Jn + g ? (unsigned int)t : (unsigned int)(Jn + g);
+  if (!(w = calloc(n ? n : 1, sizeof (*w)))) {
+    fprintf(stderr, "%s: out of memory\n", Me);
+    return (2);
+  }
+  for (i = 0; i < n; ++i)
+    if (!(w[i].c = malloc(rmd320tsize())) || !(w[i].tc = malloc(rmd320treetsize()))
+     || posix_memalign(&w[i].b, 4096, BUFSZ)
+     || (Tree && posix_memalign(&w[i].lb, 4096, (size_t)GROUP * RMD320_CHUNK))) {
+      fprintf(stderr, "%s: out of memory\n", Me);
+      return (2);
+    } else
+      w[i].u = uringopen(DEPTH, CHUNK);
+  /* this thread is the first worker */
+  for (i = 1; i < n; ++i)
+    if (pthread_create(&w[i].t, 0, worker, w + i))
+      break;
+  if (n)
+    worker(w);
+  while (--i > 0)
+    pthread_join(w[i].t, 0);
+  for (i = 0; i < n; ++i) {
+    uringclose(w[i].u);
+    free(w[i].lb);
+    free(w[i].b);
+    free(w[i].tc);
+    free(w[i].c);
+  }
+  free(w);
+  free(J);
+  return (Bad);
+}
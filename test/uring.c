@@ -0,0 +1,264 @@
+#define _GNU_SOURCE /* syscall, MAP_POPULATE */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "uring.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define URING 1
+#endif
+#endif
+
+#ifdef URING
+
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+#define PENDING INT_MIN /* result of a read still in flight */
+
+struct uring {
+  int fd;
+  unsigned int q;             /* buffers, the most reads in flight */
+  unsigned int z;             /* bytes per buffer */
+  int fixed;                  /* buffers registered, else plain readv */
+  int lost;                   /* the kernel may still own the buffers */
+  unsigned char *b;           /* q buffers of z bytes */
+  struct iovec *v;            /* one per buffer */
+  int *r;                     /* read result per buffer */
+  unsigned int *g;            /* bytes already in each buffer */
+  void *sm;                   /* submission ring */
+  size_t sl;
+  void *cm;                   /* completion ring, sm if mapped together */
+  size_t cl;
+  struct io_uring_sqe *se;    /* submission entries */
+  size_t el;
+  unsigned int *sh;           /* submission head, tail, mask, index array */
+  unsigned int *st;
+  unsigned int *sk;
+  unsigned int *sa;
+  unsigned int *ch;           /* completion head, tail, mask, entries */
+  unsigned int *ct;
+  unsigned int *ck;
+  struct io_uring_cqe *ce;
+};
+
+void
+uringclose(
+  uring_t *u
+){
+  if (!u)
+    return;
+  if (u->se != MAP_FAILED)
+    munmap(u->se, u->el);
+  if (u->cm != MAP_FAILED && u->cm != u->sm)
+    munmap(u->cm, u->cl);
+  if (u->sm != MAP_FAILED)
+    munmap(u->sm, u->sl);
+  if (u->fd >= 0)
+    close(u->fd);
+  free(u->g);
+  free(u->r);
+  free(u->v);
+  if (!u->lost) /* else leaked rather than handed back while reads may land in it */
+    free(u->b);
+  free(u);
+}
+
+uring_t *
+uringopen(
+  unsigned int q
+ ,unsigned int z
+){
+  struct io_uring_params p;
+  uring_t *u;
+  void *b;
+  unsigned int i;
+
+  if (!q || !z || !(u = calloc(1, sizeof (*u))))
+    return (0);
+  u->sm = u->cm = u->se = MAP_FAILED;
+  u->q = q;
+  u->z = z;
+  memset(&p, 0, sizeof (p));
+  if ((u->fd = (int)syscall(__NR_io_uring_setup, q, &p)) < 0) {
+    uringclose(u);
+    return (0);
+  }
+  u->sl = p.sq_off.array + p.sq_entries * sizeof (unsigned int);
+  u->cl = p.cq_off.cqes + p.cq_entries * sizeof (struct io_uring_cqe);
+  u->el = p.sq_entries * sizeof (struct io_uring_sqe);
+  if ((p.features & IORING_FEAT_SINGLE_MMAP) && u->sl < u->cl)
+    u->sl = u->cl;
+  if ((u->sm = mmap(0, u->sl, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING)) == MAP_FAILED
+   || (u->cm = p.features & IORING_FEAT_SINGLE_MMAP ? u->sm
+     : mmap(0, u->cl, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING)) == MAP_FAILED
+   || (u->se = mmap(0, u->el, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES)) == MAP_FAILED
+   || posix_memalign(&b, 4096, (size_t)q * z)
+   || (u->b = b, !(u->v = malloc(q * sizeof (*u->v))))
+   || !(u->r = malloc(q * sizeof (*u->r)))
+   || !(u->g = malloc(q * sizeof (*u->g)))) {
+    uringclose(u);
+    return (0);
+  }
+  u->sh = (unsigned int *)((char *)u->sm + p.sq_off.head);
+  u->st = (unsigned int *)((char *)u->sm + p.sq_off.tail);
+  u->sk = (unsigned int *)((char *)u->sm + p.sq_off.ring_mask);
+  u->sa = (unsigned int *)((char *)u->sm + p.sq_off.array);
+  u->ch = (unsigned int *)((char *)u->cm + p.cq_off.head);
+  u->ct = (unsigned int *)((char *)u->cm + p.cq_off.tail);
+  u->ck = (unsigned int *)((char *)u->cm + p.cq_off.ring_mask);
+  u->ce = (struct io_uring_cqe *)((char *)u->cm + p.cq_off.cqes);
+  for (i = 0; i < q; ++i) {
+    u->v[i].iov_base = u->b + (size_t)i * z;
+    u->v[i].iov_len = z;
+  }
+  /* pinning counts against RLIMIT_MEMLOCK, without it readv into the same buffers */
+  u->fixed = !syscall(__NR_io_uring_register, u->fd, IORING_REGISTER_BUFFERS, u->v, q);
+  return (u);
+}
+
+/* queue a read of l bytes of chunk k into its buffer after the g already there */
+static void
+uringsqe(
+  uring_t *u
+ ,int f
+ ,unsigned int k
+ ,long long o
+ ,unsigned int g
+ ,unsigned int l
+){
+  struct io_uring_sqe *e;
+  unsigned int t;
+  unsigned int i;
+
+  t = *u->st;
+  i = t & *u->sk;
+  e = u->se + i;
+  memset(e, 0, sizeof (*e));
+  e->fd = f;
+  e->off = (unsigned long long)o;
+  e->user_data = k;
+  u->v[k % u->q].iov_base = u->b + (size_t)(k % u->q) * u->z + g;
+  if (u->fixed) {
+    e->opcode = IORING_OP_READ_FIXED;
+    e->addr = (unsigned long)u->v[k % u->q].iov_base;
+    e->len = l;
+    e->buf_index = (unsigned short)(k % u->q);
+  } else {
+    u->v[k % u->q].iov_len = l;
+    e->opcode = IORING_OP_READV;
+    e->addr = (unsigned long)(u->v + k % u->q);
+    e->len = 1;
+  }
+  u->sa[i] = i;
+  __atomic_store_n(u->st, t + 1, __ATOMIC_RELEASE);
+}
+
+int
+uringread(
+  uring_t *u
+ ,int f
+ ,long long o
+ ,long long n
+ ,void (*h)(void *, const unsigned char *, size_t)
+ ,void *a
+){
+  long long i; /* bytes queued */
+  unsigned int s; /* chunks queued */
+  unsigned int p; /* reads queued but not yet submitted */
+  unsigned int l; /* reads in flight */
+  unsigned int d; /* chunks handed to h */
+  unsigned int k;
+  unsigned int t;
+  int e;
+  int r;
+
+  i = 0;
+  s = p = l = d = 0;
+  e = 0;
+  for (;;) {
+    for (; !e && i < n && s - d < u->q; ++s, ++p, ++l) {
+      t = n - i < u->z ? (unsigned int)(n - i) : u->z;
+      u->r[s % u->q] = PENDING;
+      u->g[s % u->q] = 0;
+      uringsqe(u, f, s, o + i, 0, t);
+      i += t;
+    }
+    if (!l)
+      break;
+    if ((r = (int)syscall(__NR_io_uring_enter, u->fd, p, 1, IORING_ENTER_GETEVENTS, 0, 0)) >= 0)
+      p -= (unsigned int)r;
+    else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      u->lost = 1; /* the ring is unusable, and may still own the buffers */
+      return (-1);
+    }
+    for (k = *u->ch; k != __atomic_load_n(u->ct, __ATOMIC_ACQUIRE); ++k, --l)
+      u->r[u->ce[k & *u->ck].user_data % u->q] = u->ce[k & *u->ck].res;
+    __atomic_store_n(u->ch, k, __ATOMIC_RELEASE);
+    for (; !e && d < s && (r = u->r[d % u->q]) != PENDING;) {
+      if (r < 0 && u->fixed)
+        e = -1; /* perhaps the registered buffers, not the file */
+      else if (r < 0)
+        e = -r;
+      else if (!r)
+        e = EIO; /* the file shrank */
+      else {
+        h(a, u->b + (size_t)(d % u->q) * u->z + u->g[d % u->q], (size_t)r);
+        u->g[d % u->q] += (unsigned int)r;
+        t = n - (long long)d * u->z < u->z ? (unsigned int)(n - (long long)d * u->z) : u->z;
+        if (u->g[d % u->q] < t) { /* short, read the rest into the same buffer */
+          u->r[d % u->q] = PENDING;
+          uringsqe(u, f, d, o + (long long)d * u->z + u->g[d % u->q], u->g[d % u->q], t - u->g[d % u->q]);
+          ++p;
+          ++l;
+        } else
+          ++d;
+      }
+    }
+  }
+  return (e);
+}
+
+#else
+
+uring_t *
+uringopen(
+  unsigned int q
+ ,unsigned int z
+){
+  (void)q;
+  (void)z;
+  return (0);
+}
+
+void
+uringclose(
+  uring_t *u
+){
+  (void)u;
+}
+
+int
+uringread(
+  uring_t *u
+ ,int f
+ ,long long o
+ ,long long n
+ ,void (*h)(void *, const unsigned char *, size_t)
+ ,void *a
+){
+  (void)u;
+  (void)f;
+  (void)o;
+  (void)n;
+  (void)h;
+  (void)a;
+  return (ENOSYS);
+}
+
+#endif
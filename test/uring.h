@@ -0,0 +1,20 @@
+#include <stddef.h>
+
+/*
+ * Read ahead engine for the drivers.
+ * A ring keeps up to depth reads of size bytes in flight into buffers
+ * allocated (and, when allowed, registered with the kernel) once,
+ * and hands each buffer to a callback in file order as it completes.
+ * Only Linux io_uring is implemented: elsewhere, or when the kernel refuses,
+ * uringopen returns 0 and the caller reads some other way.
+ */
+
+typedef struct uring uring_t;
+
+uring_t *uringopen(unsigned int depth, unsigned int size); /* 0 if unavailable */
+void uringclose(uring_t *);
+
+/* feed bytes [offset, offset + length) of a file to f(a, buffer, bytes), returns 0 or errno */
+/* short reads are read on, the file ending early (it shrank) is EIO */
+/* -1 if the ring failed rather than the file: f has seen a prefix, close the ring and read another way */
+int uringread(uring_t *, int fd, long long offset, long long length, void (*f)(void *, const unsigned char *, size_t), void *a);